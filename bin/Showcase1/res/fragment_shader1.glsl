@@ -0,0 +1,6 @@
+#version 330 core
+uniform vec3 color;
+void main()
+{
+    gl_FragColor = vec4(color, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 330 core
+in vec3 color;
+
+void main()
+{
+    gl_FragColor = vec4(color, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 input_color;
+out vec3 color;
+void main()
+{
+    gl_Position = vec4(position.x, position.y, position.z, 1.0f);
+    color = input_color;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef BOUNDING_VOLUME_H
+#define BOUNDING_VOLUME_H
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Sphere enclosing a renderable. Laid out as a vec4 (center, radius) so arrays of them can be loaded straight into SIMD registers.
+ */
+struct bounding_sphere{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+static_assert(sizeof(bounding_sphere) == 4 * sizeof(float), "bounding_sphere must stay packed as four floats");
+
+/**
+ * @brief Builds a sphere around interleaved vertex positions, centered on their bounding box.
+ * @param vertices The first float of the first vertex position.
+ * @param vertex_count The number of vertices.
+ * @param stride The number of floats between two consecutive positions.
+ * @return The enclosing sphere, zero sized if there are no vertices.
+ */
+bounding_sphere sphere_from_points(const float* vertices, size_t vertex_count, size_t stride){
+    bounding_sphere sphere;
+    if(vertex_count == 0){
+        return sphere;
+    }
+    glm::vec3 low(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 high = low;
+    for(size_t i = 1; i < vertex_count; i++){
+        const float* position = vertices + i * stride;
+        glm::vec3 point(position[0], position[1], position[2]);
+        low = glm::min(low, point);
+        high = glm::max(high, point);
+    }
+    sphere.center = (low + high) * 0.5f;
+    float radius_squared = 0.0f;
+    for(size_t i = 0; i < vertex_count; i++){
+        const float* position = vertices + i * stride;
+        glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - sphere.center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(radius_squared);
+    return sphere;
+}
+
+/**
+ * @brief Moves a local sphere into world space. Non uniform scales grow the radius by the largest axis scale.
+ * @param local The sphere in model space.
+ * @param model The model matrix.
+ * @return The sphere in world space.
+ */
+bounding_sphere transform_bounds(const bounding_sphere& local, const glm::mat4& model){
+    bounding_sphere world;
+    world.center = glm::vec3(model * glm::vec4(local.center, 1.0f));
+    float scale_squared = std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+        std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+    world.radius = local.radius * std::sqrt(scale_squared);
+    return world;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Returns the 64-bit FNV-1a hash of a buffer.
+ * @param data The buffer.
+ * @param size Its size in bytes.
+ * @param hash The hash to continue, the FNV offset basis starts a new one.
+ */
+uint64_t hash_bytes(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull){
+    for(size_t i = 0; i < size; i++){
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Reads a whole file.
+ * @param path The file path.
+ * @param bytes Receives the contents.
+ * @return False if the file cannot be read.
+ */
+bool read_whole_file(const std::string& path, std::vector<unsigned char>& bytes){
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file == NULL){
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    bytes.resize(size > 0 ? size_t(size) : 0);
+    bool read = size > 0 && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    fclose(file);
+    return read;
+}
+
+/**
+ * @brief Replaces a file with new contents. The data is written next to it and renamed, so no reader ever sees a half
+ * written file. A read-only folder is not an error the callers have to handle, the file is just not written.
+ * @param path The file path.
+ * @param data The new contents.
+ * @param size Their size in bytes.
+ * @return False if the file could not be written.
+ */
+bool replace_file(const std::string& path, const void* data, size_t size){
+    std::string temporary_path = path + ".tmp";
+    FILE* file = fopen(temporary_path.c_str(), "wb");
+    if(file == NULL){
+        return false;
+    }
+    bool written = fwrite(data, 1, size, file) == size;
+    written = fclose(file) == 0 && written;
+    std::remove(path.c_str());
+    if(!written || std::rename(temporary_path.c_str(), path.c_str()) != 0){
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+/**
+ * @brief Turns variable frame times into a whole number of fixed simulation steps.
+ * The time left over after the last step is carried to the next frame; its fraction of a step is the factor the renderer
+ * interpolates with between the previous and the current simulation state, so motion stays smooth at any step rate.
+ */
+class fixed_timestep{
+public:
+    /**
+     * @brief Creates the clock.
+     * @param steps_per_second The simulation rate.
+     * @param max_steps The most steps a single frame may run, the time beyond them is dropped.
+     */
+    explicit fixed_timestep(double steps_per_second = 60.0, int max_steps = 8);
+    /**
+     * @brief Changes the simulation rate, the time carried over is kept.
+     * @param steps_per_second The new rate.
+     */
+    void set_rate(double steps_per_second);
+    /**
+     * @brief Adds the time of a frame and returns how many steps to simulate before rendering it. After a long stall the
+     * simulation slows down for one frame instead of running ever more steps to catch up.
+     * @param frame_time The time elapsed since the last frame, in seconds.
+     * @return The number of steps, at most max_steps.
+     */
+    int advance(double frame_time);
+    /**
+     * @brief Returns the interpolation factor of the current frame, from 0 (previous state) to 1 (current state).
+     */
+    float alpha() const;
+    /**
+     * @brief Returns the duration of one step, in seconds.
+     */
+    float step_time() const;
+    /**
+     * @brief Returns the simulation rate, in steps per second.
+     */
+    double rate() const;
+    /**
+     * @brief Returns the simulated time, the sum of every step run so far.
+     */
+    double time() const;
+    /**
+     * @brief Returns the number of steps run so far.
+     */
+    long long steps() const;
+    /**
+     * @brief Returns the time dropped so far because a frame needed more than max_steps.
+     */
+    double dropped_time() const;
+private:
+    double step = 1.0 / 60.0;
+    int max_frame_steps = 8;
+    double accumulator = 0.0;
+    double simulated = 0.0;
+    double dropped = 0.0;
+    long long step_count = 0;
+};
+
+fixed_timestep::fixed_timestep(double steps_per_second, int max_steps) : step(1.0 / steps_per_second), max_frame_steps(max_steps){}
+
+void fixed_timestep::set_rate(double steps_per_second){
+    step = 1.0 / steps_per_second;
+}
+
+int fixed_timestep::advance(double frame_time){
+    accumulator += frame_time > 0.0 ? frame_time : 0.0;
+    int count = int(accumulator / step);
+    if(count > max_frame_steps){
+        dropped += accumulator - max_frame_steps * step;
+        accumulator = max_frame_steps * step;
+        count = max_frame_steps;
+    }
+    accumulator -= count * step;
+    simulated += count * step;
+    step_count += count;
+    return count;
+}
+
+float fixed_timestep::alpha() const{
+    float factor = float(accumulator / step);
+    return factor < 1.0f ? factor : 1.0f;
+}
+
+float fixed_timestep::step_time() const{
+    return float(step);
+}
+
+double fixed_timestep::rate() const{
+    return 1.0 / step;
+}
+
+double fixed_timestep::time() const{
+    return simulated;
+}
+
+long long fixed_timestep::steps() const{
+    return step_count;
+}
+
+double fixed_timestep::dropped_time() const{
+    return dropped;
+}
+
+#endif
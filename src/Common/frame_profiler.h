@@ -0,0 +1,281 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Frames of CPU and GPU times kept per pass
+const int PROFILER_HISTORY = 240;
+// Timer queries are read back this many frames after they were issued, so reading them never stalls the pipeline
+const int PROFILER_LATENCY = 3;
+
+/**
+ * @brief Summary of a profiler history, in milliseconds.
+ */
+struct profile_summary{
+    float min = 0.0f;
+    float avg = 0.0f;
+    float max = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+};
+
+/**
+ * @brief Ring buffer of the last PROFILER_HISTORY samples of one timer.
+ */
+class profile_history{
+public:
+    /**
+     * @brief Adds a sample, overwriting the oldest one once the buffer is full.
+     * @param value The sample in milliseconds.
+     */
+    void push(float value);
+    /**
+     * @brief Returns the min, average, max and percentiles of the stored samples.
+     */
+    profile_summary summary() const;
+    /**
+     * @brief Returns the samples in storage order, start at offset() to read them oldest first.
+     */
+    const float* data() const{ return samples; }
+    int offset() const{ return count < PROFILER_HISTORY ? 0 : next; }
+    int size() const{ return count; }
+    float last() const{ return count > 0 ? samples[(next + PROFILER_HISTORY - 1) % PROFILER_HISTORY] : 0.0f; }
+private:
+    float samples[PROFILER_HISTORY] = {};
+    int next = 0;
+    int count = 0;
+};
+
+void profile_history::push(float value){
+    samples[next] = value;
+    next = (next + 1) % PROFILER_HISTORY;
+    count = std::min(count + 1, PROFILER_HISTORY);
+}
+
+profile_summary profile_history::summary() const{
+    profile_summary result;
+    if(count == 0){
+        return result;
+    }
+    std::vector<float> sorted(samples, samples + count);
+    std::sort(sorted.begin(), sorted.end());
+    float sum = 0.0f;
+    for(float sample : sorted){
+        sum += sample;
+    }
+    // Nearest rank percentiles
+    auto percentile = [&](float fraction){
+        int rank = int(fraction * float(count) + 0.999f) - 1;
+        return sorted[std::min(std::max(rank, 0), count - 1)];
+    };
+    result.min = sorted.front();
+    result.avg = sum / float(count);
+    result.max = sorted.back();
+    result.p50 = percentile(0.50f);
+    result.p95 = percentile(0.95f);
+    result.p99 = percentile(0.99f);
+    return result;
+}
+
+/**
+ * @brief The CPU and GPU time histories of one named pass.
+ */
+struct profile_pass{
+    std::string name;
+    profile_history cpu;
+    profile_history gpu;
+};
+
+/**
+ * @brief Frame profiler: splits every frame into sequential segments, each one charged to a pass.
+ * A segment measures its CPU time with a clock and its GPU time with a GL_TIME_ELAPSED query.
+ * A pass can get several segments per frame (e.g. one while its draws are submitted and one while they are issued),
+ * their times are added up. Query results are collected PROFILER_LATENCY frames later, a frame whose queries are
+ * still not available by then is left out of the GPU histories. So is a frame whose GPU time is longer than the time
+ * since it started, some drivers (e.g. llvmpipe) return a timestamp instead of a duration from their first query.
+ */
+class frame_profiler{
+public:
+    /**
+     * @brief Registers a pass.
+     * @param name The name shown by the profiler panel.
+     * @return The ID to begin segments of the pass with.
+     */
+    int add_pass(const std::string& name);
+    /**
+     * @brief Collects the GPU times of an old frame and starts timing a new one.
+     */
+    void begin_frame();
+    /**
+     * @brief Ends the running segment and starts one of a pass, segments never nest.
+     * @param pass The pass ID.
+     */
+    void begin(int pass);
+    /**
+     * @brief Ends the running segment, the time until the next begin() is not charged to any pass.
+     */
+    void end();
+    /**
+     * @brief Ends the frame and pushes the CPU times of every pass to their histories.
+     */
+    void end_frame();
+    /**
+     * @brief Returns the pass of the running segment, or -1 outside of segments.
+     */
+    int active_pass() const{ return current_pass; }
+    const std::vector<profile_pass>& passes() const{ return pass_list; }
+    const profile_history& frame_cpu() const{ return frame_cpu_history; }
+    const profile_history& frame_gpu() const{ return frame_gpu_history; }
+    /**
+     * @brief Returns false if the context has no timer queries, only CPU times are recorded then.
+     */
+    bool gpu_timing() const{ return timer_queries; }
+    /**
+     * @brief Returns the number of frames left out of the GPU histories because their queries were late or invalid.
+     */
+    int dropped_frames() const{ return dropped_frame_count; }
+private:
+    // The timer queries issued in one frame and the pass of each
+    struct query_frame{
+        std::vector<GLuint> queries;
+        std::vector<int> query_passes;
+        int used = 0;
+        bool pending = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::vector<profile_pass> pass_list;
+    std::vector<double> frame_cpu_ms;
+    profile_history frame_cpu_history;
+    profile_history frame_gpu_history;
+    query_frame query_frames[PROFILER_LATENCY + 1];
+    int frame_index = 0;
+    int current_pass = -1;
+    bool query_running = false;
+    bool timer_queries = false;
+    bool initialised = false;
+    bool in_frame = false;
+    int dropped_frame_count = 0;
+    std::chrono::steady_clock::time_point frame_start;
+    std::chrono::steady_clock::time_point segment_start;
+
+    void collect(query_frame& frame);
+};
+
+int frame_profiler::add_pass(const std::string& name){
+    profile_pass pass;
+    pass.name = name;
+    pass_list.push_back(pass);
+    frame_cpu_ms.push_back(0.0);
+    return int(pass_list.size()) - 1;
+}
+
+void frame_profiler::collect(query_frame& frame){
+    if(!frame.pending){
+        return;
+    }
+    frame.pending = false;
+    if(frame.used == 0){
+        return;
+    }
+    // Queries finish in order, the last one being ready means all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available){
+        dropped_frame_count++;
+        return;
+    }
+    std::vector<double> gpu_ms(pass_list.size(), 0.0);
+    double total = 0.0;
+    for(int i = 0; i < frame.used; i++){
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+        gpu_ms[frame.query_passes[i]] += double(elapsed) / 1e6;
+        total += double(elapsed) / 1e6;
+    }
+    if(total > std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.start).count()){
+        dropped_frame_count++;
+        return;
+    }
+    for(size_t pass = 0; pass < pass_list.size(); pass++){
+        pass_list[pass].gpu.push(float(gpu_ms[pass]));
+    }
+    frame_gpu_history.push(float(total));
+}
+
+void frame_profiler::begin_frame(){
+    if(!initialised){
+        initialised = true;
+        timer_queries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    }
+    frame_index++;
+    query_frame& frame = query_frames[frame_index % (PROFILER_LATENCY + 1)];
+    collect(frame);
+    frame.used = 0;
+    frame.start = std::chrono::steady_clock::now();
+    std::fill(frame_cpu_ms.begin(), frame_cpu_ms.end(), 0.0);
+    in_frame = true;
+    frame_start = frame.start;
+}
+
+void frame_profiler::begin(int pass){
+    end();
+    if(!in_frame){
+        return;
+    }
+    current_pass = pass;
+    if(timer_queries){
+        query_frame& frame = query_frames[frame_index % (PROFILER_LATENCY + 1)];
+        if(frame.used == int(frame.queries.size())){
+            GLuint query;
+            glGenQueries(1, &query);
+            frame.queries.push_back(query);
+            frame.query_passes.push_back(-1);
+        }
+        frame.query_passes[frame.used] = pass;
+        glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.used]);
+        frame.used++;
+        query_running = true;
+    }
+    segment_start = std::chrono::steady_clock::now();
+}
+
+void frame_profiler::end(){
+    if(current_pass < 0){
+        return;
+    }
+    frame_cpu_ms[current_pass] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - segment_start).count();
+    if(query_running){
+        glEndQuery(GL_TIME_ELAPSED);
+        query_running = false;
+    }
+    current_pass = -1;
+}
+
+void frame_profiler::end_frame(){
+    end();
+    if(!in_frame){
+        return;
+    }
+    in_frame = false;
+    frame_cpu_history.push(float(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count()));
+    for(size_t pass = 0; pass < pass_list.size(); pass++){
+        pass_list[pass].cpu.push(float(frame_cpu_ms[pass]));
+    }
+    query_frames[frame_index % (PROFILER_LATENCY + 1)].pending = true;
+}
+
+/**
+ * @brief Returns the profiler shared by the render code of the program.
+ */
+frame_profiler& profiler(){
+    static frame_profiler instance;
+    return instance;
+}
+
+#endif
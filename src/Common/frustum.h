@@ -0,0 +1,108 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "glm/glm.hpp"
+#include "bounding_volume.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief The six planes of a view frustum in world space, normals pointing inwards and normalised
+ * so that dot(plane.xyz, point) + plane.w is the signed distance of the point.
+ */
+struct frustum{
+    glm::vec4 planes[6];
+};
+
+/**
+ * @brief Extracts the frustum planes from the camera matrices (Gribb/Hartmann).
+ * @param projection The projection matrix.
+ * @param view The view matrix.
+ * @return The world space frustum.
+ */
+frustum extract_frustum(const glm::mat4& projection, const glm::mat4& view){
+    glm::mat4 clip = projection * view;
+    // glm is column major, clip[column][row]
+    glm::vec4 rows[4];
+    for(int row = 0; row < 4; row++){
+        rows[row] = glm::vec4(clip[0][row], clip[1][row], clip[2][row], clip[3][row]);
+    }
+    frustum result;
+    result.planes[0] = rows[3] + rows[0]; // left
+    result.planes[1] = rows[3] - rows[0]; // right
+    result.planes[2] = rows[3] + rows[1]; // bottom
+    result.planes[3] = rows[3] - rows[1]; // top
+    result.planes[4] = rows[3] + rows[2]; // near
+    result.planes[5] = rows[3] - rows[2]; // far
+    for(glm::vec4& plane : result.planes){
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return result;
+}
+
+/**
+ * @brief Returns true if any part of the sphere can be inside the frustum.
+ * @param view_frustum The frustum.
+ * @param sphere The world space sphere.
+ */
+bool is_visible(const frustum& view_frustum, const bounding_sphere& sphere){
+    for(const glm::vec4& plane : view_frustum.planes){
+        if(glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tests an array of spheres against the frustum, four at a time when SSE is available.
+ * @param view_frustum The frustum.
+ * @param spheres The world space spheres.
+ * @param count The number of spheres.
+ * @param visible Receives 1 for every sphere that can be visible and 0 for the culled ones.
+ * @return The number of visible spheres.
+ */
+int cull_spheres(const frustum& view_frustum, const bounding_sphere* spheres, int count, unsigned char* visible){
+    int visible_count = 0;
+    int i = 0;
+#ifdef FRUSTUM_USE_SSE
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    for(int p = 0; p < 6; p++){
+        plane_x[p] = _mm_set1_ps(view_frustum.planes[p].x);
+        plane_y[p] = _mm_set1_ps(view_frustum.planes[p].y);
+        plane_z[p] = _mm_set1_ps(view_frustum.planes[p].z);
+        plane_w[p] = _mm_set1_ps(view_frustum.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for(; i + 4 <= count; i += 4){
+        // Four (x, y, z, r) spheres become one register per component
+        __m128 center_x = _mm_loadu_ps(&spheres[i].center.x);
+        __m128 center_y = _mm_loadu_ps(&spheres[i + 1].center.x);
+        __m128 center_z = _mm_loadu_ps(&spheres[i + 2].center.x);
+        __m128 radius = _mm_loadu_ps(&spheres[i + 3].center.x);
+        _MM_TRANSPOSE4_PS(center_x, center_y, center_z, radius);
+        __m128 negative_radius = _mm_sub_ps(zero, radius);
+        __m128 inside = _mm_cmpeq_ps(zero, zero); // all lanes set
+        for(int p = 0; p < 6; p++){
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], center_x), _mm_mul_ps(plane_y[p], center_y)),
+                _mm_add_ps(_mm_mul_ps(plane_z[p], center_z), plane_w[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for(int lane = 0; lane < 4; lane++){
+            visible[i + lane] = (mask >> lane) & 1;
+            visible_count += visible[i + lane];
+        }
+    }
+#endif
+    for(; i < count; i++){
+        visible[i] = is_visible(view_frustum, spheres[i]) ? 1 : 0;
+        visible_count += visible[i];
+    }
+    return visible_count;
+}
+
+#endif
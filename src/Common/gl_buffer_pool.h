@@ -0,0 +1,138 @@
+#ifndef GL_BUFFER_POOL_H
+#define GL_BUFFER_POOL_H
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// Buffer sizes are rounded up to this many bytes, so buffers of slightly different requests can be reused for each other
+const size_t GL_BUFFER_POOL_GRANULE = 64 * 1024;
+
+/**
+ * @brief Free list of GL buffer objects for transient data, such as the staging buffers of texture uploads.
+ * Released buffers keep their storage and are handed out again instead of being deleted and recreated; a fence placed
+ * at release makes sure the GPU has finished reading a buffer before it is reused. prewarm() creates buffers up front,
+ * so that a steady stream of requests makes no driver allocations at all.
+ */
+class gl_buffer_pool{
+public:
+    gl_buffer_pool() = default;
+    gl_buffer_pool(const gl_buffer_pool&) = delete;
+    gl_buffer_pool& operator=(const gl_buffer_pool&) = delete;
+    /**
+     * @brief Creates buffers and puts them on the free list.
+     * @param target The binding target used to create them (e.g. GL_PIXEL_UNPACK_BUFFER).
+     * @param size The size of every buffer in bytes.
+     * @param count The number of buffers.
+     */
+    void prewarm(GLenum target, size_t size, int count);
+    /**
+     * @brief Returns a buffer of at least size bytes, bound to the target. Its contents are undefined.
+     * @param target The binding target.
+     * @param size The size needed in bytes.
+     * @return The buffer, reused from the free list when one is large enough and no longer read by the GPU.
+     */
+    GLuint acquire(GLenum target, size_t size);
+    /**
+     * @brief Returns a buffer to the free list once the commands that read it are issued.
+     * @param buffer A buffer returned by acquire().
+     */
+    void release(GLuint buffer);
+    /**
+     * @brief Returns the number of buffers created so far.
+     */
+    int created() const;
+    /**
+     * @brief Returns the number of requests served from the free list.
+     */
+    int reused() const;
+    /**
+     * @brief Returns the number of buffers on the free list.
+     */
+    int free_buffers() const;
+private:
+    struct pooled_buffer{
+        GLuint id;
+        size_t capacity;
+        GLsync fence; // 0 once the GPU is known to be done with the buffer
+    };
+    GLuint create(GLenum target, size_t capacity);
+
+    std::vector<pooled_buffer> free_list;
+    std::unordered_map<GLuint, size_t> capacities; // of every buffer of the pool
+    int created_count = 0;
+    int reused_count = 0;
+};
+
+GLuint gl_buffer_pool::create(GLenum target, size_t capacity){
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, GLsizeiptr(capacity), nullptr, GL_STREAM_DRAW);
+    capacities[buffer] = capacity;
+    created_count++;
+    return buffer;
+}
+
+void gl_buffer_pool::prewarm(GLenum target, size_t size, int count){
+    size_t capacity = (size + GL_BUFFER_POOL_GRANULE - 1) / GL_BUFFER_POOL_GRANULE * GL_BUFFER_POOL_GRANULE;
+    for(int i = 0; i < count; i++){
+        free_list.push_back(pooled_buffer{create(target, capacity), capacity, 0});
+    }
+    glBindBuffer(target, 0);
+}
+
+GLuint gl_buffer_pool::acquire(GLenum target, size_t size){
+    // The smallest free buffer that fits and that the GPU is done with
+    int best = -1;
+    for(int i = 0; i < int(free_list.size()); i++){
+        pooled_buffer& candidate = free_list[i];
+        if(candidate.capacity < size || (best >= 0 && candidate.capacity >= free_list[best].capacity)){
+            continue;
+        }
+        if(candidate.fence != 0){
+            if(glClientWaitSync(candidate.fence, 0, 0) == GL_TIMEOUT_EXPIRED){
+                continue;
+            }
+            glDeleteSync(candidate.fence);
+            candidate.fence = 0;
+        }
+        best = i;
+    }
+    if(best < 0){
+        return create(target, (size + GL_BUFFER_POOL_GRANULE - 1) / GL_BUFFER_POOL_GRANULE * GL_BUFFER_POOL_GRANULE);
+    }
+    GLuint buffer = free_list[best].id;
+    free_list[best] = free_list.back();
+    free_list.pop_back();
+    reused_count++;
+    glBindBuffer(target, buffer);
+    return buffer;
+}
+
+void gl_buffer_pool::release(GLuint buffer){
+    free_list.push_back(pooled_buffer{buffer, capacities[buffer], glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+}
+
+int gl_buffer_pool::created() const{
+    return created_count;
+}
+
+int gl_buffer_pool::reused() const{
+    return reused_count;
+}
+
+int gl_buffer_pool::free_buffers() const{
+    return int(free_list.size());
+}
+
+/**
+ * @brief Returns the buffer pool shared by the whole application.
+ */
+gl_buffer_pool& buffer_pool(){
+    static gl_buffer_pool pool;
+    return pool;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <GL/glew.h>
+
+const int GL_STATE_TEXTURE_UNITS = 16;
+
+/**
+ * @brief Bind counters of a frame. requested counts every call, the rest only the ones that reached GL.
+ */
+struct gl_state_stats{
+    int program_requests = 0;
+    int program_switches = 0;
+    int vertex_array_requests = 0;
+    int vertex_array_binds = 0;
+    int texture_requests = 0;
+    int texture_binds = 0;
+};
+
+/**
+ * @brief Remembers the bound program, VAO and textures and drops binds that would not change anything.
+ * Code that binds behind its back (e.g. ImGui, loading code) is covered by invalidate(), called at the start of every frame.
+ */
+class gl_state_cache{
+public:
+    /**
+     * @brief Forgets every cached binding, the next bind of each kind always reaches GL.
+     */
+    void invalidate();
+    /**
+     * @brief Invalidates the cache and moves the counters of the frame that ended to last_frame().
+     */
+    void begin_frame();
+    /**
+     * @brief Makes the program current.
+     * @param program The program ID.
+     */
+    void use_program(GLuint program);
+    /**
+     * @brief Binds the vertex array object.
+     * @param VAO The VAO ID.
+     */
+    void bind_vertex_array(GLuint VAO);
+    /**
+     * @brief Binds a texture to a texture unit.
+     * @param unit The texture unit, starting at 0.
+     * @param target The texture target (e.g. GL_TEXTURE_2D).
+     * @param texture The texture ID.
+     */
+    void bind_texture(int unit, GLenum target, GLuint texture);
+    /**
+     * @brief Returns the counters of the last finished frame.
+     */
+    const gl_state_stats& last_frame() const;
+private:
+    struct texture_binding{
+        GLenum target;
+        GLuint texture;
+    };
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    GLuint program = UNKNOWN;
+    GLuint vertex_array = UNKNOWN;
+    int active_unit = -1;
+    texture_binding textures[GL_STATE_TEXTURE_UNITS];
+    gl_state_stats current;
+    gl_state_stats finished;
+};
+
+void gl_state_cache::invalidate(){
+    program = UNKNOWN;
+    vertex_array = UNKNOWN;
+    active_unit = -1;
+    for(texture_binding& binding : textures){
+        binding.target = 0;
+        binding.texture = UNKNOWN;
+    }
+}
+
+void gl_state_cache::begin_frame(){
+    invalidate();
+    finished = current;
+    current = gl_state_stats();
+}
+
+void gl_state_cache::use_program(GLuint new_program){
+    current.program_requests++;
+    if(program != new_program){
+        glUseProgram(new_program);
+        program = new_program;
+        current.program_switches++;
+    }
+}
+
+void gl_state_cache::bind_vertex_array(GLuint VAO){
+    current.vertex_array_requests++;
+    if(vertex_array != VAO){
+        glBindVertexArray(VAO);
+        vertex_array = VAO;
+        current.vertex_array_binds++;
+    }
+}
+
+void gl_state_cache::bind_texture(int unit, GLenum target, GLuint texture){
+    current.texture_requests++;
+    if(unit < GL_STATE_TEXTURE_UNITS && textures[unit].target == target && textures[unit].texture == texture){
+        return;
+    }
+    if(active_unit != unit){
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit = unit;
+    }
+    glBindTexture(target, texture);
+    if(unit < GL_STATE_TEXTURE_UNITS){
+        textures[unit].target = target;
+        textures[unit].texture = texture;
+    }
+    current.texture_binds++;
+}
+
+const gl_state_stats& gl_state_cache::last_frame() const{
+    return finished;
+}
+
+/**
+ * @brief Returns the GL state cache shared by the whole application.
+ */
+gl_state_cache& gl_state(){
+    static gl_state_cache cache;
+    return cache;
+}
+
+#endif
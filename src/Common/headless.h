@@ -0,0 +1,344 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#ifdef HEADLESS_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Frames a headless run renders when neither --frames nor --seconds is given
+const int HEADLESS_DEFAULT_FRAMES = 600;
+
+/**
+ * @brief How a showcase runs, read from its command line:
+ * --headless renders offscreen into a framebuffer object instead of a window,
+ * --size WxH sets the size of that framebuffer,
+ * --frames N and --seconds S end the run and print a timing report, in both modes.
+ */
+struct run_options{
+    bool headless = false;
+    int width = 0;
+    int height = 0;
+    int frame_limit = 0; // 0 means no limit
+    double time_limit = 0.0; // 0 means no limit
+    double fixed_frame_time = 0.0; // simulated time of every frame for showcases with a fixed timestep, 0 uses the clock
+};
+
+/**
+ * @brief Parses the command line of a showcase, unknown arguments end the program with the usage.
+ * @param argc The argument count given to main.
+ * @param argv The arguments given to main.
+ * @param window_width The width of the window, also the default framebuffer width.
+ * @param window_height The height of the window, also the default framebuffer height.
+ * @return The parsed options.
+ */
+run_options parse_run_options(int argc, char** argv, int window_width, int window_height){
+    run_options options;
+    options.width = window_width;
+    options.height = window_height;
+    bool size_given = false;
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if(argument == "--headless"){
+            options.headless = true;
+        }else if(argument == "--size" && has_value && sscanf(argv[i + 1], "%dx%d", &options.width, &options.height) == 2
+            && options.width > 0 && options.height > 0){
+            size_given = true;
+            i++;
+        }else if(argument == "--frames" && has_value && (options.frame_limit = atoi(argv[i + 1])) > 0){
+            i++;
+        }else if(argument == "--seconds" && has_value && (options.time_limit = atof(argv[i + 1])) > 0.0){
+            i++;
+        }else if(argument == "--fixed-frame-time" && has_value && (options.fixed_frame_time = atof(argv[i + 1])) > 0.0){
+            i++;
+        }else{
+            std::cout << "Usage: " << argv[0] << " [--headless] [--size WIDTHxHEIGHT] [--frames N] [--seconds S] [--fixed-frame-time S]\n";
+            exit(1);
+        }
+    }
+    if(size_given && !options.headless){
+        std::cout << "--size only applies to --headless runs, the window keeps its size.\n";
+        options.width = window_width;
+        options.height = window_height;
+    }
+    if(options.headless && options.frame_limit == 0 && options.time_limit == 0.0){
+        options.frame_limit = HEADLESS_DEFAULT_FRAMES;
+    }
+    return options;
+}
+
+#ifdef HEADLESS_USE_EGL
+static EGLDisplay headless_display = EGL_NO_DISPLAY;
+static EGLContext headless_egl_context = EGL_NO_CONTEXT;
+static EGLSurface headless_surface = EGL_NO_SURFACE;
+
+/**
+ * @brief Creates an EGL context with no window system and makes it current. Mesa's surfaceless platform
+ * is preferred, so it also works under llvmpipe with no display server.
+ * @param options The parsed options, the size is only used if a pbuffer surface is needed.
+ * @param gl_major The OpenGL major version to request.
+ * @param gl_minor The OpenGL minor version to request.
+ * @param gl_profile GLFW_OPENGL_CORE_PROFILE or GLFW_OPENGL_COMPAT_PROFILE.
+ * @return True if a context is current.
+ */
+bool create_egl_context(const run_options& options, int gl_major, int gl_minor, int gl_profile){
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(client_extensions != NULL && strstr(client_extensions, "EGL_MESA_platform_surfaceless") != NULL && get_platform_display != NULL){
+        headless_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if(headless_display == EGL_NO_DISPLAY){
+        headless_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if(headless_display == EGL_NO_DISPLAY || !eglInitialize(headless_display, &major, &minor)){
+        headless_display = EGL_NO_DISPLAY;
+        return false;
+    }
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint config_count = 0;
+    if(!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(headless_display, config_attributes, &config, 1, &config_count) || config_count == 0){
+        return false;
+    }
+    EGLint profile = gl_profile == GLFW_OPENGL_COMPAT_PROFILE ? EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT : EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT;
+    const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION, gl_major, EGL_CONTEXT_MINOR_VERSION, gl_minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, profile, EGL_NONE};
+    headless_egl_context = eglCreateContext(headless_display, config, EGL_NO_CONTEXT, context_attributes);
+    if(headless_egl_context == EGL_NO_CONTEXT){
+        return false;
+    }
+    // Rendering goes to our own framebuffer, a surface is only created for drivers without surfaceless contexts
+    if(eglMakeCurrent(headless_display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless_egl_context)){
+        return true;
+    }
+    const EGLint surface_attributes[] = {EGL_WIDTH, options.width, EGL_HEIGHT, options.height, EGL_NONE};
+    headless_surface = eglCreatePbufferSurface(headless_display, config, surface_attributes);
+    return headless_surface != EGL_NO_SURFACE && eglMakeCurrent(headless_display, headless_surface, headless_surface, headless_egl_context);
+}
+
+/**
+ * @brief Releases the EGL context, surface and display if they were created.
+ */
+void destroy_egl_context(){
+    if(headless_display == EGL_NO_DISPLAY){
+        return;
+    }
+    eglMakeCurrent(headless_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(headless_surface != EGL_NO_SURFACE){
+        eglDestroySurface(headless_display, headless_surface);
+    }
+    if(headless_egl_context != EGL_NO_CONTEXT){
+        eglDestroyContext(headless_display, headless_egl_context);
+    }
+    eglTerminate(headless_display);
+    headless_display = EGL_NO_DISPLAY;
+    headless_egl_context = EGL_NO_CONTEXT;
+    headless_surface = EGL_NO_SURFACE;
+}
+#endif
+
+static GLuint headless_framebuffer = 0;
+static GLuint headless_renderbuffers[2] = {0, 0};
+
+/**
+ * @brief Initiates GLFW and an offscreen OpenGL context, then binds a framebuffer object of the requested size
+ * that every frame renders into. With EGL the context needs no display at all and GLFW runs on its null platform,
+ * which still provides the window handle, input and timer the showcases use. Without EGL, or when it fails,
+ * a hidden GLFW window provides the context instead.
+ * @param WINDOW_NAME The title of the (never shown) window.
+ * @param options The parsed options, width and height give the framebuffer size.
+ * @param gl_major The OpenGL major version to request.
+ * @param gl_minor The OpenGL minor version to request.
+ * @param gl_profile GLFW_OPENGL_CORE_PROFILE or GLFW_OPENGL_COMPAT_PROFILE.
+ * @return A pointer to the created GLFWwindow.
+ */
+GLFWwindow* initiate_headless(const std::string WINDOW_NAME, const run_options& options, int gl_major, int gl_minor, int gl_profile){
+    GLFWwindow* window = NULL;
+    bool glx_required = true;
+#ifdef HEADLESS_USE_EGL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if(glfwInit()){
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow(options.width, options.height, WINDOW_NAME.c_str(), NULL, NULL);
+        if(window != NULL && create_egl_context(options, gl_major, gl_minor, gl_profile)){
+            glx_required = false;
+        }else{
+            std::cout << "EGL context could not be created, falling back to a hidden window.\n";
+            destroy_egl_context();
+            glfwTerminate();
+            window = NULL;
+        }
+    }
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+#endif
+    if(window == NULL){
+        if(!glfwInit()){
+            std::cout << "GLFW could not be initialized! Terminating...\n";
+            exit(1);
+        }
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, gl_major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, gl_minor);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, gl_profile);
+        window = glfwCreateWindow(options.width, options.height, WINDOW_NAME.c_str(), NULL, NULL);
+        if(window == NULL){
+            std::cout << "Window could not be initialized! Terminating...\n";
+            glfwTerminate();
+            exit(1);
+        }
+        glfwMakeContextCurrent(window);
+    }
+
+    // GLEW also loads GLX, which has no display to talk to under EGL, the GL entry points are loaded regardless
+    GLenum glew_status = glewInit();
+    if(glew_status != GLEW_OK && (glx_required || glew_status != GLEW_ERROR_NO_GLX_DISPLAY)){
+        std::cout << "GLEW could not be initialized! Terminating...\n";
+        glfwTerminate();
+        exit(1);
+    }
+
+    glGenRenderbuffers(2, headless_renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless_renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless_renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &headless_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless_renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headless_renderbuffers[1]);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cout << "Offscreen framebuffer is incomplete! Terminating...\n";
+        glfwTerminate();
+        exit(1);
+    }
+    glViewport(0, 0, options.width, options.height);
+    return window;
+}
+
+/**
+ * @brief Releases the offscreen framebuffer and context, call it before terminating GLFW.
+ */
+void terminate_headless(){
+    if(headless_framebuffer != 0){
+        glDeleteFramebuffers(1, &headless_framebuffer);
+        glDeleteRenderbuffers(2, headless_renderbuffers);
+        headless_framebuffer = 0;
+    }
+#ifdef HEADLESS_USE_EGL
+    destroy_egl_context();
+#endif
+}
+
+/**
+ * @brief Returns a percentile of sorted samples, nearest rank.
+ * @param sorted The samples in ascending order, not empty.
+ * @param fraction The percentile as a fraction, e.g. 0.95.
+ */
+double sorted_percentile(const std::vector<double>& sorted, double fraction){
+    return sorted[std::min(sorted.size() - 1, size_t(fraction * double(sorted.size())))];
+}
+
+/**
+ * @brief Drives the frame loop of a showcase: ends it when the window closes or a frame/time limit is reached,
+ * presents the frame and records how long every frame took.
+ */
+class run_timer{
+public:
+    /**
+     * @brief Creates the timer.
+     * @param options The parsed options, the limits and the mode are read from it.
+     */
+    explicit run_timer(const run_options& options);
+    /**
+     * @brief Records the frame that just ended and tells if another one should run, use it as the loop condition.
+     * @param window The showcase window.
+     */
+    bool keep_running(GLFWwindow* window);
+    /**
+     * @brief Presents the frame. Headless runs have nothing to swap and wait for the GPU instead,
+     * so the recorded frame times include the rendering.
+     * @param window The showcase window.
+     */
+    void end_frame(GLFWwindow* window);
+    /**
+     * @brief Prints the frame count and the frame time statistics, only for runs with a limit or in headless mode.
+     * @param name The name of the showcase.
+     */
+    void report(const std::string& name) const;
+private:
+    run_options options;
+    bool started = false;
+    double start_time = 0.0;
+    double last_time = 0.0;
+    std::vector<double> frame_times;
+};
+
+run_timer::run_timer(const run_options& run_options) : options(run_options){}
+
+bool run_timer::keep_running(GLFWwindow* window){
+    double now = glfwGetTime();
+    if(!started){
+        started = true;
+        start_time = now;
+    }else{
+        frame_times.push_back(now - last_time);
+    }
+    last_time = now;
+    if(glfwWindowShouldClose(window)){
+        return false;
+    }
+    if(options.frame_limit > 0 && int(frame_times.size()) >= options.frame_limit){
+        return false;
+    }
+    return options.time_limit <= 0.0 || now - start_time < options.time_limit;
+}
+
+void run_timer::end_frame(GLFWwindow* window){
+    if(options.headless){
+        glFinish();
+    }else{
+        glfwSwapBuffers(window);
+    }
+}
+
+void run_timer::report(const std::string& name) const{
+    if(!options.headless && options.frame_limit == 0 && options.time_limit == 0.0){
+        return;
+    }
+    if(frame_times.empty()){
+        std::cout << name << ": no frames rendered\n";
+        return;
+    }
+    // The first frame also compiles shaders and uploads resources, it is reported on its own
+    std::vector<double> sorted(frame_times.begin() + 1, frame_times.end());
+    std::sort(sorted.begin(), sorted.end());
+    double total = last_time - start_time;
+    printf("%s: %d frames in %.3f s, %dx%d %s\n", name.c_str(), int(frame_times.size()), total,
+        options.width, options.height, options.headless ? "offscreen" : "window");
+    printf("  first frame %.3f ms\n", frame_times[0] * 1000.0);
+    if(sorted.empty()){
+        return;
+    }
+    double sum = 0.0;
+    for(double time : sorted){
+        sum += time;
+    }
+    printf("  frame time ms: avg %.3f, min %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f (%.1f FPS)\n",
+        sum / double(sorted.size()) * 1000.0, sorted.front() * 1000.0, sorted_percentile(sorted, 0.5) * 1000.0,
+        sorted_percentile(sorted, 0.95) * 1000.0, sorted_percentile(sorted, 0.99) * 1000.0, sorted.back() * 1000.0,
+        double(sorted.size()) / sum);
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed pool of worker threads with one job deque each.
+ * A worker pops the newest job of its own deque and, once that is empty, steals the oldest job of another deque,
+ * so big ranges get split where the work is and idle threads take the halves nobody has started yet.
+ * The calling thread takes part in every parallel_for, it owns deque 0.
+ * Background tasks queued with async() wait in a separate FIFO that only the workers take from, after their ranges.
+ */
+class job_system{
+public:
+    /**
+     * @brief Starts the workers.
+     * @param worker_count Number of extra threads, 0 uses one per hardware thread besides the caller.
+     */
+    explicit job_system(unsigned int worker_count = 0);
+    ~job_system();
+    job_system(const job_system&) = delete;
+    job_system& operator=(const job_system&) = delete;
+    /**
+     * @brief Runs body over [0, count) split in ranges of at most grain items and returns once every range is done.
+     * Ranges run concurrently, body must only touch data of its own range. Must not be called from inside a job.
+     * @param count The number of items.
+     * @param grain The largest range handed to a single call of body.
+     * @param body Called with the begin and end of each range.
+     */
+    void parallel_for(int count, int grain, const std::function<void(int, int)>& body);
+    /**
+     * @brief Queues a task for the workers and returns at once, tasks start in the order they were queued.
+     * A parallel_for never runs background tasks on its calling thread. Without workers the task runs before async returns.
+     * @param task The task, it must not call parallel_for.
+     */
+    void async(std::function<void()> task);
+    /**
+     * @brief Returns the number of threads working on a parallel_for, including the caller.
+     */
+    int thread_count() const;
+private:
+    struct job{
+        const std::function<void(int, int)>* body;
+        int begin;
+        int end;
+        int grain;
+        std::atomic<int>* completed;
+    };
+    struct job_queue{
+        std::mutex lock;
+        std::deque<job> jobs;
+    };
+    void push(int queue, const job& new_job);
+    bool pop(int queue, job& taken);
+    bool steal(int thief, job& taken);
+    void run(int queue, job current);
+    void worker_loop(int queue);
+
+    std::vector<std::unique_ptr<job_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> queued_jobs{0};
+    std::deque<std::function<void()>> background_tasks; // guarded by sleep_lock
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+job_system::job_system(unsigned int worker_count){
+    if(worker_count == 0){
+        unsigned int hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+    for(unsigned int i = 0; i <= worker_count; i++){
+        queues.push_back(std::make_unique<job_queue>());
+    }
+    for(unsigned int i = 1; i <= worker_count; i++){
+        workers.emplace_back(&job_system::worker_loop, this, int(i));
+    }
+}
+
+job_system::~job_system(){
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+void job_system::parallel_for(int count, int grain, const std::function<void(int, int)>& body){
+    if(count <= 0){
+        return;
+    }
+    if(grain < 1){
+        grain = 1;
+    }
+    if(workers.empty() || count <= grain){
+        body(0, count);
+        return;
+    }
+    std::atomic<int> completed{0};
+    run(0, job{&body, 0, count, grain, &completed});
+    // Help with whatever is left until the last range of this call is done
+    while(completed.load(std::memory_order_acquire) < count){
+        job taken;
+        if(pop(0, taken) || steal(0, taken)){
+            run(0, taken);
+        }else{
+            std::this_thread::yield();
+        }
+    }
+}
+
+void job_system::async(std::function<void()> task){
+    if(workers.empty()){
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        background_tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+int job_system::thread_count() const{
+    return int(queues.size());
+}
+
+void job_system::push(int queue, const job& new_job){
+    {
+        std::lock_guard<std::mutex> guard(queues[queue]->lock);
+        queues[queue]->jobs.push_back(new_job);
+    }
+    queued_jobs.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the lock makes sure a worker about to sleep sees the new job
+        std::lock_guard<std::mutex> guard(sleep_lock);
+    }
+    wake.notify_one();
+}
+
+bool job_system::pop(int queue, job& taken){
+    std::lock_guard<std::mutex> guard(queues[queue]->lock);
+    if(queues[queue]->jobs.empty()){
+        return false;
+    }
+    taken = queues[queue]->jobs.back();
+    queues[queue]->jobs.pop_back();
+    queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool job_system::steal(int thief, job& taken){
+    int queue_count = int(queues.size());
+    for(int offset = 1; offset < queue_count; offset++){
+        job_queue& victim = *queues[(thief + offset) % queue_count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.jobs.empty()){
+            taken = victim.jobs.front();
+            victim.jobs.pop_front();
+            queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void job_system::run(int queue, job current){
+    // Keep the lower half and offer the upper half to thieves until the range is small enough
+    while(current.end - current.begin > current.grain){
+        int middle = current.begin + (current.end - current.begin) / 2;
+        job upper = current;
+        upper.begin = middle;
+        push(queue, upper);
+        current.end = middle;
+    }
+    (*current.body)(current.begin, current.end);
+    current.completed->fetch_add(current.end - current.begin, std::memory_order_release);
+}
+
+void job_system::worker_loop(int queue){
+    while(true){
+        job taken;
+        if(pop(queue, taken) || steal(queue, taken)){
+            run(queue, taken);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake.wait(guard, [this](){
+            return stopping || queued_jobs.load(std::memory_order_acquire) > 0 || !background_tasks.empty();
+        });
+        if(stopping){
+            return;
+        }
+        if(queued_jobs.load(std::memory_order_acquire) == 0 && !background_tasks.empty()){
+            std::function<void()> task = std::move(background_tasks.front());
+            background_tasks.pop_front();
+            guard.unlock();
+            task();
+        }
+    }
+}
+
+/**
+ * @brief Returns the job system shared by the whole application.
+ */
+job_system& job_pool(){
+    static job_system pool;
+    return pool;
+}
+
+#endif
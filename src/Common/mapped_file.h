@@ -0,0 +1,127 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only memory mapping of a whole file, unmapped when the object is closed or destroyed.
+ */
+class mapped_file{
+public:
+    mapped_file() = default;
+    ~mapped_file();
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    /**
+     * @brief Maps a file, closing the previously mapped one.
+     * @param path The file path.
+     * @return False if the file does not exist, is empty or cannot be mapped.
+     */
+    bool open(const std::string& path);
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+    const unsigned char* data() const{ return bytes; }
+    size_t size() const{ return length; }
+    bool is_open() const{ return bytes != nullptr; }
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+};
+
+mapped_file::~mapped_file(){
+    close();
+}
+
+#ifdef _WIN32
+bool mapped_file::open(const std::string& path){
+    close();
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0){
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL){
+        close();
+        return false;
+    }
+    bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(bytes == nullptr){
+        close();
+        return false;
+    }
+    length = size_t(file_size.QuadPart);
+    return true;
+}
+
+void mapped_file::close(){
+    if(bytes != nullptr){
+        UnmapViewOfFile(bytes);
+    }
+    if(mapping != NULL){
+        CloseHandle(mapping);
+    }
+    if(file != INVALID_HANDLE_VALUE){
+        CloseHandle(file);
+    }
+    bytes = nullptr;
+    length = 0;
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+}
+#else
+bool mapped_file::open(const std::string& path){
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0){
+        return false;
+    }
+    struct stat file_info;
+    if(fstat(descriptor, &file_info) != 0 || file_info.st_size <= 0){
+        ::close(descriptor);
+        return false;
+    }
+    // The mapping stays valid after the descriptor is closed
+    void* mapping = mmap(nullptr, size_t(file_info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if(mapping == MAP_FAILED){
+        return false;
+    }
+    bytes = (const unsigned char*)mapping;
+    length = size_t(file_info.st_size);
+    return true;
+}
+
+void mapped_file::close(){
+    if(bytes != nullptr){
+        munmap((void*)bytes, length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef MESH_BAKE_H
+#define MESH_BAKE_H
+
+#include "glm/glm.hpp"
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "file_io.h"
+#include "job_system.h"
+#include "mesh_generator.h"
+
+// Triangles and vertices handed to one job of the parallel passes
+const int MESH_BAKE_GRAIN = 4096;
+// The largest cache the vertex cache optimisation models, larger requests are clamped
+const int MESH_BAKE_MAX_CACHE = 64;
+
+/**
+ * @brief Lists the triangles that use each vertex, in increasing triangle order.
+ * A triangle that uses a vertex twice is listed twice.
+ */
+struct vertex_adjacency{
+    std::vector<unsigned int> offsets; // triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v + 1] - 1]
+    std::vector<unsigned int> triangles;
+    /**
+     * @brief Builds the lists of an index buffer.
+     * @param indices The triangle list.
+     * @param vertex_count The number of vertices the indices refer to.
+     */
+    void build(const std::vector<unsigned int>& indices, size_t vertex_count);
+};
+
+void vertex_adjacency::build(const std::vector<unsigned int>& indices, size_t vertex_count){
+    offsets.assign(vertex_count + 1, 0);
+    for(unsigned int index : indices){
+        offsets[index + 1]++;
+    }
+    for(size_t i = 0; i < vertex_count; i++){
+        offsets[i + 1] += offsets[i];
+    }
+    triangles.resize(indices.size());
+    std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < indices.size(); i++){
+        triangles[filled[indices[i]]++] = (unsigned int)(i / 3);
+    }
+}
+
+/**
+ * @brief Merges vertices whose position, normal and texture coordinates are bitwise equal, keeping the first of each.
+ * Negative zeros in them are turned positive first, cross products produce them for normals along an axis.
+ * The tangents are ignored, they have to be generated again afterwards.
+ * @param mesh The mesh, its indices are remapped.
+ * @return The number of vertices removed.
+ */
+size_t weld_vertices(mesh_data& mesh){
+    // The keys are the attributes in front of the tangent
+    struct vertex_key_hash{
+        size_t operator()(const float* key) const{
+            return size_t(hash_bytes((const unsigned char*)key, MESH_TANGENT_OFFSET * sizeof(float)));
+        }
+    };
+    struct vertex_key_equal{
+        bool operator()(const float* a, const float* b) const{
+            return memcmp(a, b, MESH_TANGENT_OFFSET * sizeof(float)) == 0;
+        }
+    };
+    size_t vertex_count = mesh.vertex_count();
+    for(size_t i = 0; i < vertex_count; i++){
+        float* key = mesh.vertices.data() + i * MESH_VERTEX_FLOATS;
+        for(int j = 0; j < MESH_TANGENT_OFFSET; j++){
+            key[j] += 0.0f; // -0 + 0 is +0, every other value stays the same
+        }
+    }
+    std::unordered_map<const float*, unsigned int, vertex_key_hash, vertex_key_equal> first_of;
+    first_of.reserve(vertex_count);
+    std::vector<unsigned int> remap(vertex_count);
+    std::vector<float> welded;
+    welded.reserve(mesh.vertices.size());
+    for(size_t i = 0; i < vertex_count; i++){
+        // The keys point into the old vertices, which stay untouched until the end
+        const float* vertex = mesh.vertices.data() + i * MESH_VERTEX_FLOATS;
+        auto inserted = first_of.emplace(vertex, (unsigned int)(welded.size() / MESH_VERTEX_FLOATS));
+        if(inserted.second){
+            welded.insert(welded.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+        }
+        remap[i] = inserted.first->second;
+    }
+    for(unsigned int& index : mesh.indices){
+        index = remap[index];
+    }
+    size_t removed = vertex_count - welded.size() / MESH_VERTEX_FLOATS;
+    mesh.vertices.swap(welded);
+    return removed;
+}
+
+/**
+ * @brief Computes the same tangent frames as generate_tangents() on the job pool: the triangle frames are computed in
+ * parallel, then every vertex sums the frames of its triangles in triangle order, so the result does not depend on
+ * the number of threads.
+ * @param mesh The mesh, its positions, normals, UVs and indices must already be filled.
+ */
+void generate_tangents_parallel(mesh_data& mesh){
+    size_t vertex_count = mesh.vertex_count();
+    int triangle_count = int(mesh.indices.size() / 3);
+    std::vector<glm::vec3> triangle_tangents(triangle_count);
+    std::vector<glm::vec3> triangle_bitangents(triangle_count);
+    float* v = mesh.vertices.data();
+    const unsigned int* indices = mesh.indices.data();
+    job_pool().parallel_for(triangle_count, MESH_BAKE_GRAIN, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            const unsigned int* corner = indices + i * 3;
+            // Degenerate triangles leave zero, which adds nothing to the sums
+            triangle_tangent_frame(v + corner[0] * MESH_VERTEX_FLOATS, v + corner[1] * MESH_VERTEX_FLOATS,
+                v + corner[2] * MESH_VERTEX_FLOATS, triangle_tangents[i], triangle_bitangents[i]);
+        }
+    });
+
+    vertex_adjacency adjacency;
+    adjacency.build(mesh.indices, vertex_count);
+    job_pool().parallel_for(int(vertex_count), MESH_BAKE_GRAIN, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            glm::vec3 tangent_sum(0.0f);
+            glm::vec3 bitangent_sum(0.0f);
+            for(unsigned int j = adjacency.offsets[i]; j < adjacency.offsets[i + 1]; j++){
+                tangent_sum += triangle_tangents[adjacency.triangles[j]];
+                bitangent_sum += triangle_bitangents[adjacency.triangles[j]];
+            }
+            write_vertex_tangent_frame(v + size_t(i) * MESH_VERTEX_FLOATS, tangent_sum, bitangent_sum);
+        }
+    });
+}
+
+/**
+ * @brief Returns the score of a vertex in the vertex cache optimisation (Tom Forsyth, "Linear-Speed Vertex Cache
+ * Optimisation"): vertices of the last triangle and vertices recently used score high, and so do vertices with few
+ * triangles left, so that lone triangles do not stay behind.
+ * @param cache_position The position in the simulated cache, -1 if the vertex is not in it.
+ * @param remaining_triangles The number of triangles using the vertex that are not emitted yet.
+ * @param cache_size The size of the simulated cache.
+ */
+float vertex_cache_score(int cache_position, unsigned int remaining_triangles, int cache_size){
+    if(remaining_triangles == 0){
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if(cache_position >= 0){
+        if(cache_position < 3){
+            score = 0.75f;
+        }else{
+            score = std::pow(1.0f - float(cache_position - 3) / float(cache_size - 3), 1.5f);
+        }
+    }
+    return score + 2.0f / std::sqrt(float(remaining_triangles));
+}
+
+/**
+ * @brief Reorders the triangles so that consecutive triangles share vertices, which keeps them in the post-transform
+ * vertex cache of the GPU. The vertices are not moved, see optimize_vertex_fetch().
+ * @param mesh The mesh, its indices are reordered.
+ * @param cache_size The number of vertices of the modelled cache, 32 suits most GPUs.
+ */
+void optimize_vertex_cache(mesh_data& mesh, int cache_size = 32){
+    cache_size = glm::clamp(cache_size, 4, MESH_BAKE_MAX_CACHE);
+    size_t vertex_count = mesh.vertex_count();
+    size_t triangle_count = mesh.indices.size() / 3;
+    if(triangle_count == 0){
+        return;
+    }
+    vertex_adjacency adjacency;
+    adjacency.build(mesh.indices, vertex_count);
+    // The live triangles of a vertex are kept at the front of its adjacency list
+    std::vector<unsigned int> remaining(vertex_count);
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for(size_t i = 0; i < vertex_count; i++){
+        remaining[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+        vertex_score[i] = vertex_cache_score(-1, remaining[i], cache_size);
+    }
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    int best = 0;
+    for(size_t i = 0; i < triangle_count; i++){
+        const unsigned int* corner = mesh.indices.data() + i * 3;
+        triangle_score[i] = vertex_score[corner[0]] + vertex_score[corner[1]] + vertex_score[corner[2]];
+        if(triangle_score[i] > triangle_score[best]){
+            best = int(i);
+        }
+    }
+
+    std::vector<unsigned int> ordered;
+    ordered.reserve(mesh.indices.size());
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> next_cache;
+    size_t scan = 0; // the triangles in front of it are all emitted
+    for(size_t done = 0; done < triangle_count; done++){
+        if(best < 0){
+            // Nothing in the cache has triangles left, restart from the first triangle not emitted yet
+            while(emitted[scan]){
+                scan++;
+            }
+            best = int(scan);
+        }
+        const unsigned int* corner = mesh.indices.data() + size_t(best) * 3;
+        ordered.insert(ordered.end(), corner, corner + 3);
+        emitted[best] = true;
+
+        // The corners move to the front of the cache, the rest keeps its order and the oldest ones fall out
+        next_cache.assign(corner, corner + 3);
+        for(int j = 0; j < 3; j++){
+            unsigned int vertex = corner[j];
+            unsigned int* live = adjacency.triangles.data() + adjacency.offsets[vertex];
+            for(unsigned int k = 0; k < remaining[vertex]; k++){
+                if(live[k] == unsigned(best)){
+                    live[k] = live[remaining[vertex] - 1];
+                    live[remaining[vertex] - 1] = unsigned(best);
+                    remaining[vertex]--;
+                    break;
+                }
+            }
+        }
+        for(unsigned int vertex : cache){
+            if(vertex != corner[0] && vertex != corner[1] && vertex != corner[2]){
+                next_cache.push_back(vertex);
+            }
+        }
+        for(size_t j = 0; j < next_cache.size(); j++){
+            cache_position[next_cache[j]] = int(j) < cache_size ? int(j) : -1;
+        }
+
+        // Rescore the vertices that moved and the triangles still using them
+        best = -1;
+        float best_score = -1.0f;
+        for(unsigned int vertex : next_cache){
+            float score = vertex_cache_score(cache_position[vertex], remaining[vertex], cache_size);
+            float delta = score - vertex_score[vertex];
+            vertex_score[vertex] = score;
+            const unsigned int* live = adjacency.triangles.data() + adjacency.offsets[vertex];
+            for(unsigned int k = 0; k < remaining[vertex]; k++){
+                triangle_score[live[k]] += delta;
+            }
+        }
+        for(unsigned int vertex : next_cache){
+            const unsigned int* live = adjacency.triangles.data() + adjacency.offsets[vertex];
+            for(unsigned int k = 0; k < remaining[vertex]; k++){
+                if(triangle_score[live[k]] > best_score){
+                    best_score = triangle_score[live[k]];
+                    best = int(live[k]);
+                }
+            }
+        }
+        if(int(next_cache.size()) > cache_size){
+            next_cache.resize(cache_size);
+        }
+        cache.swap(next_cache);
+    }
+    mesh.indices.swap(ordered);
+}
+
+/**
+ * @brief Reorders the vertices in the order the indices first use them, so the vertex fetch reads memory in sequence.
+ * Vertices no index uses are dropped.
+ * @param mesh The mesh, its vertices are reordered and its indices remapped.
+ */
+void optimize_vertex_fetch(mesh_data& mesh){
+    const unsigned int unused = 0xFFFFFFFFu;
+    std::vector<unsigned int> remap(mesh.vertex_count(), unused);
+    std::vector<float> ordered;
+    ordered.reserve(mesh.vertices.size());
+    for(unsigned int& index : mesh.indices){
+        if(remap[index] == unused){
+            remap[index] = (unsigned int)(ordered.size() / MESH_VERTEX_FLOATS);
+            const float* vertex = mesh.vertices.data() + size_t(index) * MESH_VERTEX_FLOATS;
+            ordered.insert(ordered.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(ordered);
+}
+
+/**
+ * @brief Returns the average number of vertices transformed per triangle (ACMR) with a FIFO post-transform cache.
+ * 3 means no reuse at all; a regular grid approaches 0.5.
+ * @param indices The triangle list.
+ * @param vertex_count The number of vertices the indices refer to.
+ * @param cache_size The number of vertices of the cache.
+ */
+float average_cache_miss_ratio(const std::vector<unsigned int>& indices, size_t vertex_count, int cache_size = 32){
+    if(indices.size() < 3){
+        return 0.0f;
+    }
+    // A vertex is cached while fewer than cache_size misses happened since its own
+    std::vector<long long> missed_at(vertex_count, -1ll - cache_size);
+    long long misses = 0;
+    for(unsigned int index : indices){
+        if(misses - missed_at[index] > cache_size){
+            missed_at[index] = misses;
+            misses++;
+        }
+    }
+    return float(misses) / float(indices.size() / 3);
+}
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "file_io.h"
+#include "mesh_generator.h"
+#include "bounding_volume.h"
+
+// Mesh file layout, native byte order: mesh_file_header, attribute_count mesh_file_attribute entries, submesh_count
+// mesh_file_submesh entries, then the vertices of every submesh at vertex_offset and their indices at index_offset.
+// Both blocks start on MESH_FILE_ALIGNMENT bytes, so a mapped file can be handed to GL as is. Written by the meshbake tool.
+const uint32_t MESH_FILE_MAGIC = 0x4853454D; // "MESH"
+const uint32_t MESH_FILE_VERSION = 2;
+const uint32_t MESH_FILE_ALIGNMENT = 16;
+const uint32_t MESH_FILE_FLOAT = 0x1406; // GL_FLOAT, the tool does not include GL
+const char* const MESH_FILE_EXTENSION = ".mesh";
+
+/**
+ * @brief Header of a mesh file.
+ */
+struct mesh_file_header{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_stride; // bytes per vertex
+    uint32_t attribute_count;
+    uint32_t submesh_count;
+    uint32_t index_size; // 2 if every index of every submesh fits in 16 bits, 4 otherwise
+    uint32_t vertex_count; // of all submeshes
+    uint32_t index_count; // of all submeshes
+    float bounds_center[3]; // model space bounding sphere of the whole mesh
+    float bounds_radius;
+    uint64_t vertex_offset; // from the start of the file
+    uint64_t index_offset;
+};
+
+/**
+ * @brief One vertex attribute, as glVertexAttribPointer takes it.
+ */
+struct mesh_file_attribute{
+    uint32_t location;
+    uint32_t components;
+    uint32_t type; // a GL type enum, MESH_FILE_FLOAT for the meshes meshbake writes
+    uint32_t offset; // in bytes from the start of the vertex
+};
+
+/**
+ * @brief A part of the mesh that can be uploaded and drawn on its own: its vertices and indices are contiguous ranges
+ * and its indices count from its first vertex.
+ */
+struct mesh_file_submesh{
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    uint32_t first_index;
+    uint32_t index_count;
+    float bounds_center[3];
+    float bounds_radius;
+};
+
+static_assert(sizeof(mesh_file_header) == 64, "mesh_file_header must not change layout");
+static_assert(sizeof(mesh_file_attribute) == 16, "mesh_file_attribute must not change layout");
+static_assert(sizeof(mesh_file_submesh) == 32, "mesh_file_submesh must not change layout");
+
+/**
+ * @brief Returns the attributes of the MESH_VERTEX_FLOATS layout of generated and baked meshes, at locations 0 to 4.
+ */
+std::vector<mesh_file_attribute> standard_mesh_attributes(){
+    const uint32_t components[5] = {3, 3, 2, 3, 3};
+    const uint32_t offsets[5] = {MESH_POSITION_OFFSET, MESH_NORMAL_OFFSET, MESH_UV_OFFSET, MESH_TANGENT_OFFSET, MESH_BITANGENT_OFFSET};
+    std::vector<mesh_file_attribute> attributes;
+    for(uint32_t i = 0; i < 5; i++){
+        attributes.push_back(mesh_file_attribute{i, components[i], MESH_FILE_FLOAT, offsets[i] * uint32_t(sizeof(float))});
+    }
+    return attributes;
+}
+
+/**
+ * @brief Rounds a file offset up to MESH_FILE_ALIGNMENT.
+ */
+uint64_t align_mesh_offset(uint64_t offset){
+    return (offset + MESH_FILE_ALIGNMENT - 1) & ~uint64_t(MESH_FILE_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Writes a mesh file with one submesh per mesh, in the MESH_VERTEX_FLOATS layout.
+ * The indices are 16-bit when no submesh has more than 65536 vertices.
+ * @param path The file path.
+ * @param submeshes The submeshes, each with indices into its own vertices.
+ * @return False if the file could not be written.
+ */
+bool save_mesh_file(const std::string& path, const std::vector<mesh_data>& submeshes){
+    std::vector<mesh_file_attribute> attributes = standard_mesh_attributes();
+    mesh_file_header header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertex_stride = MESH_VERTEX_FLOATS * sizeof(float);
+    header.attribute_count = uint32_t(attributes.size());
+    header.submesh_count = uint32_t(submeshes.size());
+    header.index_size = 2;
+    std::vector<mesh_file_submesh> table;
+    std::vector<float> all_positions;
+    for(const mesh_data& mesh : submeshes){
+        mesh_file_submesh entry;
+        entry.first_vertex = header.vertex_count;
+        entry.vertex_count = uint32_t(mesh.vertex_count());
+        entry.first_index = header.index_count;
+        entry.index_count = uint32_t(mesh.indices.size());
+        bounding_sphere bounds = sphere_from_points(mesh.vertices.data() + MESH_POSITION_OFFSET, mesh.vertex_count(), MESH_VERTEX_FLOATS);
+        memcpy(entry.bounds_center, &bounds.center, sizeof(entry.bounds_center));
+        entry.bounds_radius = bounds.radius;
+        table.push_back(entry);
+        header.vertex_count += entry.vertex_count;
+        header.index_count += entry.index_count;
+        if(mesh.vertex_count() > 0x10000){
+            header.index_size = 4;
+        }
+        for(size_t i = 0; i < mesh.vertex_count(); i++){
+            const float* position = mesh.vertices.data() + i * MESH_VERTEX_FLOATS + MESH_POSITION_OFFSET;
+            all_positions.insert(all_positions.end(), position, position + 3);
+        }
+    }
+    bounding_sphere bounds = sphere_from_points(all_positions.data(), header.vertex_count, 3);
+    memcpy(header.bounds_center, &bounds.center, sizeof(header.bounds_center));
+    header.bounds_radius = bounds.radius;
+    size_t tables = sizeof(header) + attributes.size() * sizeof(mesh_file_attribute) + table.size() * sizeof(mesh_file_submesh);
+    header.vertex_offset = align_mesh_offset(tables);
+    header.index_offset = align_mesh_offset(header.vertex_offset + uint64_t(header.vertex_count) * header.vertex_stride);
+
+    std::vector<unsigned char> bytes(size_t(header.index_offset) + size_t(header.index_count) * header.index_size, 0);
+    unsigned char* cursor = bytes.data();
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    memcpy(cursor, attributes.data(), attributes.size() * sizeof(mesh_file_attribute));
+    cursor += attributes.size() * sizeof(mesh_file_attribute);
+    memcpy(cursor, table.data(), table.size() * sizeof(mesh_file_submesh));
+    for(size_t i = 0; i < submeshes.size(); i++){
+        const mesh_data& mesh = submeshes[i];
+        memcpy(bytes.data() + header.vertex_offset + size_t(table[i].first_vertex) * header.vertex_stride, mesh.vertices.data(),
+            mesh.vertices.size() * sizeof(float));
+        unsigned char* indices = bytes.data() + header.index_offset + size_t(table[i].first_index) * header.index_size;
+        for(size_t j = 0; j < mesh.indices.size(); j++){
+            if(header.index_size == 2){
+                uint16_t index = uint16_t(mesh.indices[j]);
+                memcpy(indices + j * 2, &index, 2);
+            }else{
+                memcpy(indices + j * 4, &mesh.indices[j], 4);
+            }
+        }
+    }
+    return replace_file(path, bytes.data(), bytes.size());
+}
+
+/**
+ * @brief Read-only view of a mesh file in memory, normally a mapped one. Only the header and the tables are read when
+ * it is opened; the vertices and indices are pointed at, never copied.
+ */
+class mesh_file_view{
+public:
+    /**
+     * @brief Checks the header and the tables of a mesh file.
+     * @param bytes The start of the file, it has to stay valid while the view is used.
+     * @param size The size of the file.
+     * @return False if the file is not a mesh file of this version, an attribute does not fit in the vertex or a range
+     * points outside of the file.
+     */
+    bool open(const unsigned char* bytes, size_t size);
+    /**
+     * @brief Checks that every index of a submesh points at one of its vertices. open() leaves this to the first upload
+     * of the submesh, so that only the index pages that get uploaded are read.
+     * @param i The submesh index.
+     */
+    bool indices_in_range(uint32_t i) const;
+    const mesh_file_header& header() const{ return file_header; }
+    const mesh_file_attribute* attributes() const{ return (const mesh_file_attribute*)(data + sizeof(mesh_file_header)); }
+    const mesh_file_submesh& submesh(uint32_t i) const{ return submesh_table()[i]; }
+    /**
+     * @brief Returns the first vertex of a submesh.
+     */
+    const unsigned char* vertices(uint32_t i) const{
+        return data + file_header.vertex_offset + size_t(submesh(i).first_vertex) * file_header.vertex_stride;
+    }
+    /**
+     * @brief Returns the first index of a submesh.
+     */
+    const unsigned char* indices(uint32_t i) const{
+        return data + file_header.index_offset + size_t(submesh(i).first_index) * file_header.index_size;
+    }
+private:
+    const unsigned char* data = nullptr;
+    mesh_file_header file_header = {};
+
+    const mesh_file_submesh* submesh_table() const{
+        return (const mesh_file_submesh*)(data + sizeof(mesh_file_header) + file_header.attribute_count * sizeof(mesh_file_attribute));
+    }
+};
+
+bool mesh_file_view::open(const unsigned char* bytes, size_t size){
+    data = nullptr;
+    if(size < sizeof(mesh_file_header)){
+        return false;
+    }
+    memcpy(&file_header, bytes, sizeof(file_header));
+    const mesh_file_header& h = file_header;
+    uint64_t tables = sizeof(mesh_file_header) + uint64_t(h.attribute_count) * sizeof(mesh_file_attribute)
+        + uint64_t(h.submesh_count) * sizeof(mesh_file_submesh);
+    if(h.magic != MESH_FILE_MAGIC || h.version != MESH_FILE_VERSION || (h.index_size != 2 && h.index_size != 4)
+        || tables > h.vertex_offset || h.vertex_offset % MESH_FILE_ALIGNMENT != 0 || h.index_offset % MESH_FILE_ALIGNMENT != 0
+        || h.vertex_offset + uint64_t(h.vertex_count) * h.vertex_stride > h.index_offset
+        || h.index_offset + uint64_t(h.index_count) * h.index_size > size || h.vertex_stride == 0){
+        return false;
+    }
+    data = bytes;
+    for(uint32_t i = 0; i < h.attribute_count; i++){
+        // Every component is a 4 byte float, the only type meshbake writes
+        const mesh_file_attribute& attribute = attributes()[i];
+        if(attribute.type != MESH_FILE_FLOAT || attribute.components < 1 || attribute.components > 4
+            || uint64_t(attribute.offset) + attribute.components * sizeof(float) > h.vertex_stride){
+            data = nullptr;
+            return false;
+        }
+    }
+    for(uint32_t i = 0; i < h.submesh_count; i++){
+        const mesh_file_submesh& entry = submesh(i);
+        if(uint64_t(entry.first_vertex) + entry.vertex_count > h.vertex_count || uint64_t(entry.first_index) + entry.index_count > h.index_count){
+            data = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool mesh_file_view::indices_in_range(uint32_t i) const{
+    const mesh_file_submesh& entry = submesh(i);
+    const unsigned char* first = indices(i);
+    for(uint32_t j = 0; j < entry.index_count; j++){
+        uint32_t index;
+        if(file_header.index_size == 2){
+            uint16_t short_index;
+            memcpy(&short_index, first + size_t(j) * 2, 2);
+            index = short_index;
+        }else{
+            memcpy(&index, first + size_t(j) * 4, 4);
+        }
+        if(index >= entry.vertex_count){
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef MESH_GENERATOR_H
+#define MESH_GENERATOR_H
+
+#include "glm/glm.hpp"
+#include <cmath>
+#include <vector>
+
+// Interleaved vertex layout shared by every generated mesh:
+// position (3), normal (3), texture coordinates (2), tangent (3), bitangent (3)
+const int MESH_VERTEX_FLOATS = 14;
+const int MESH_POSITION_OFFSET = 0;
+const int MESH_NORMAL_OFFSET = 3;
+const int MESH_UV_OFFSET = 6;
+const int MESH_TANGENT_OFFSET = 8;
+const int MESH_BITANGENT_OFFSET = 11;
+
+/**
+ * @brief Indexed triangle mesh in the MESH_VERTEX_FLOATS layout, counter-clockwise front faces.
+ */
+struct mesh_data{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    /**
+     * @brief Returns the number of vertices.
+     */
+    size_t vertex_count() const{ return vertices.size() / MESH_VERTEX_FLOATS; }
+    /**
+     * @brief Appends a vertex with zero tangent and bitangent, filled in later by generate_tangents.
+     * @return The index of the new vertex.
+     */
+    unsigned int add_vertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv);
+};
+
+unsigned int mesh_data::add_vertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv){
+    unsigned int index = (unsigned int)vertex_count();
+    float vertex[MESH_VERTEX_FLOATS] = {
+        position.x, position.y, position.z,
+        normal.x, normal.y, normal.z,
+        uv.x, uv.y,
+        0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f
+    };
+    vertices.insert(vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+    return index;
+}
+
+/**
+ * @brief Computes the unnormalised tangent and bitangent of one triangle from its corners.
+ * @param v0 The first corner, in the MESH_VERTEX_FLOATS layout.
+ * @param v1 The second corner.
+ * @param v2 The third corner.
+ * @param tangent Receives the tangent.
+ * @param bitangent Receives the bitangent.
+ * @return False if the UVs of the triangle are degenerate (e.g. at the poles of a sphere), the outputs are then zero.
+ */
+bool triangle_tangent_frame(const float* v0, const float* v1, const float* v2, glm::vec3& tangent, glm::vec3& bitangent){
+    glm::vec3 edge1 = glm::vec3(v1[0], v1[1], v1[2]) - glm::vec3(v0[0], v0[1], v0[2]);
+    glm::vec3 edge2 = glm::vec3(v2[0], v2[1], v2[2]) - glm::vec3(v0[0], v0[1], v0[2]);
+    glm::vec2 delta_uv1 = glm::vec2(v1[6], v1[7]) - glm::vec2(v0[6], v0[7]);
+    glm::vec2 delta_uv2 = glm::vec2(v2[6], v2[7]) - glm::vec2(v0[6], v0[7]);
+
+    float denominator = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+    if(std::fabs(denominator) < 1e-12f){
+        tangent = glm::vec3(0.0f);
+        bitangent = glm::vec3(0.0f);
+        return false;
+    }
+    float f = 1.0f / denominator;
+    tangent = (edge1 * delta_uv2.y - edge2 * delta_uv1.y) * f;
+    bitangent = (edge2 * delta_uv1.x - edge1 * delta_uv2.x) * f;
+    return true;
+}
+
+/**
+ * @brief Writes the tangent frame of a vertex from the summed frames of its triangles.
+ * The tangent is orthogonalised against the normal and the bitangent keeps the handedness of the UV mapping.
+ * @param vertex The vertex, in the MESH_VERTEX_FLOATS layout, its normal must be set.
+ * @param tangent_sum The sum of the tangents of the triangles using the vertex.
+ * @param bitangent_sum The sum of their bitangents.
+ */
+void write_vertex_tangent_frame(float* vertex, const glm::vec3& tangent_sum, const glm::vec3& bitangent_sum){
+    glm::vec3 n(vertex[3], vertex[4], vertex[5]);
+    // Gram-Schmidt against the normal
+    glm::vec3 t = tangent_sum - n * glm::dot(n, tangent_sum);
+    if(glm::dot(t, t) < 1e-12f){
+        // No UV gradient at this vertex, any direction perpendicular to the normal will do
+        t = (std::fabs(n.x) < 0.9f) ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    t = glm::normalize(t);
+    float handedness = (glm::dot(glm::cross(n, t), bitangent_sum) < 0.0f) ? -1.0f : 1.0f;
+    glm::vec3 b = glm::cross(n, t) * handedness;
+
+    vertex[MESH_TANGENT_OFFSET + 0] = t.x;
+    vertex[MESH_TANGENT_OFFSET + 1] = t.y;
+    vertex[MESH_TANGENT_OFFSET + 2] = t.z;
+    vertex[MESH_BITANGENT_OFFSET + 0] = b.x;
+    vertex[MESH_BITANGENT_OFFSET + 1] = b.y;
+    vertex[MESH_BITANGENT_OFFSET + 2] = b.z;
+}
+
+/**
+ * @brief Computes per-vertex tangents and bitangents from the triangle UVs of an indexed mesh.
+ * Tangents are orthogonalised against the normal and the bitangent keeps the handedness of the UV mapping.
+ * @param mesh The mesh, its positions, normals, UVs and indices must already be filled.
+ */
+void generate_tangents(mesh_data& mesh){
+    size_t vertex_count = mesh.vertex_count();
+    std::vector<glm::vec3> tangent_sum(vertex_count, glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangent_sum(vertex_count, glm::vec3(0.0f));
+    float* v = mesh.vertices.data();
+
+    for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3){
+        unsigned int corner[3] = {mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]};
+        glm::vec3 tangent, bitangent;
+        if(!triangle_tangent_frame(v + corner[0] * MESH_VERTEX_FLOATS, v + corner[1] * MESH_VERTEX_FLOATS,
+            v + corner[2] * MESH_VERTEX_FLOATS, tangent, bitangent)){
+            continue;
+        }
+        for(int j = 0; j < 3; j++){
+            tangent_sum[corner[j]] += tangent;
+            bitangent_sum[corner[j]] += bitangent;
+        }
+    }
+
+    for(size_t i = 0; i < vertex_count; i++){
+        write_vertex_tangent_frame(v + i * MESH_VERTEX_FLOATS, tangent_sum[i], bitangent_sum[i]);
+    }
+}
+
+/**
+ * @brief Generates an axis aligned cube centered at the origin, 4 vertices and 2 triangles per face.
+ * @param size The edge length.
+ * @return The indexed mesh (24 vertices, 36 indices).
+ */
+mesh_data generate_cube(float size = 1.0f){
+    // Per face: normal, then the U and V axes of the face with cross(U, V) == normal
+    const glm::vec3 faces[6][3] = {
+        {glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(-1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+        {glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+        {glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f,  1.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+        {glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f,  0.0f)},
+        {glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 0.0f,  1.0f)},
+        {glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 0.0f, -1.0f)}
+    };
+    const glm::vec2 corners[4] = {
+        glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)
+    };
+    float half = size * 0.5f;
+    mesh_data mesh;
+    mesh.vertices.reserve(24 * MESH_VERTEX_FLOATS);
+    mesh.indices.reserve(36);
+    for(int face = 0; face < 6; face++){
+        const glm::vec3& normal = faces[face][0];
+        const glm::vec3& u = faces[face][1];
+        const glm::vec3& v = faces[face][2];
+        unsigned int first = 0;
+        for(int corner = 0; corner < 4; corner++){
+            glm::vec2 uv = corners[corner];
+            glm::vec3 position = (normal + u * (uv.x * 2.0f - 1.0f) + v * (uv.y * 2.0f - 1.0f)) * half;
+            unsigned int index = mesh.add_vertex(position, normal, uv);
+            if(corner == 0){
+                first = index;
+            }
+        }
+        unsigned int quad[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+        mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    }
+    generate_tangents(mesh);
+    return mesh;
+}
+
+/**
+ * @brief Generates a plane on the XZ axis centered at the origin, facing +Y.
+ * @param width The extent on the X axis.
+ * @param depth The extent on the Z axis.
+ * @param subdivisions The number of quads along each side.
+ * @return The indexed mesh, UVs span [0, 1] over the whole plane.
+ */
+mesh_data generate_plane(float width = 1.0f, float depth = 1.0f, int subdivisions = 1){
+    if(subdivisions < 1){
+        subdivisions = 1;
+    }
+    mesh_data mesh;
+    int row = subdivisions + 1;
+    mesh.vertices.reserve(row * row * MESH_VERTEX_FLOATS);
+    mesh.indices.reserve(subdivisions * subdivisions * 6);
+    for(int j = 0; j < row; j++){
+        for(int i = 0; i < row; i++){
+            glm::vec2 uv(float(i) / subdivisions, float(j) / subdivisions);
+            glm::vec3 position((uv.x - 0.5f) * width, 0.0f, (0.5f - uv.y) * depth);
+            mesh.add_vertex(position, glm::vec3(0.0f, 1.0f, 0.0f), uv);
+        }
+    }
+    for(int j = 0; j < subdivisions; j++){
+        for(int i = 0; i < subdivisions; i++){
+            unsigned int a = j * row + i;
+            unsigned int b = a + 1;
+            unsigned int c = a + row + 1;
+            unsigned int d = a + row;
+            unsigned int quad[6] = {a, b, c, a, c, d};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    generate_tangents(mesh);
+    return mesh;
+}
+
+/**
+ * @brief Generates a UV sphere centered at the origin.
+ * @param radius The radius of the sphere.
+ * @param sectors The number of segments around the Y axis.
+ * @param stacks The number of segments from pole to pole.
+ * @return The indexed mesh, U wraps around the Y axis and V runs from the south to the north pole.
+ */
+mesh_data generate_sphere(float radius = 0.5f, int sectors = 32, int stacks = 16){
+    if(sectors < 3){
+        sectors = 3;
+    }
+    if(stacks < 2){
+        stacks = 2;
+    }
+    const float pi = 3.14159265358979f;
+    mesh_data mesh;
+    int row = sectors + 1; // the seam is duplicated so that U can reach 1
+    mesh.vertices.reserve((stacks + 1) * row * MESH_VERTEX_FLOATS);
+    mesh.indices.reserve(stacks * sectors * 6);
+    for(int stack = 0; stack <= stacks; stack++){
+        float phi = pi * float(stack) / stacks;
+        for(int sector = 0; sector <= sectors; sector++){
+            float theta = 2.0f * pi * float(sector) / sectors;
+            glm::vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            glm::vec2 uv(float(sector) / sectors, 1.0f - float(stack) / stacks);
+            mesh.add_vertex(normal * radius, normal, uv);
+        }
+    }
+    for(int stack = 0; stack < stacks; stack++){
+        for(int sector = 0; sector < sectors; sector++){
+            unsigned int a = stack * row + sector;
+            unsigned int b = a + row;
+            unsigned int c = b + 1;
+            unsigned int d = a + 1;
+            // The pole rows collapse to a point, skip the triangle that would be degenerate there
+            if(stack != 0){
+                unsigned int triangle[3] = {a, d, c};
+                mesh.indices.insert(mesh.indices.end(), triangle, triangle + 3);
+            }
+            if(stack != stacks - 1){
+                unsigned int triangle[3] = {a, c, b};
+                mesh.indices.insert(mesh.indices.end(), triangle, triangle + 3);
+            }
+        }
+    }
+    generate_tangents(mesh);
+    return mesh;
+}
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef MESH_REGISTRY_H
+#define MESH_REGISTRY_H
+
+#include <GL/glew.h>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "mesh_generator.h"
+#include "mesh_file.h"
+#include "mapped_file.h"
+#include "bounding_volume.h"
+
+/**
+ * @brief An indexed mesh uploaded once and shared by every object that draws it.
+ * Generated meshes use attributes 0-4 of the MESH_VERTEX_FLOATS layout, mesh files bring their own; shaders simply ignore
+ * the attributes they do not declare.
+ */
+struct gpu_mesh{
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    GLsizei index_count = 0;
+    GLsizei vertex_count = 0;
+    GLenum index_type = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT for mesh files with 16-bit indices
+    bounding_sphere bounds; // in model space
+    std::vector<mesh_file_attribute> layout = standard_mesh_attributes();
+    GLsizei vertex_stride = MESH_VERTEX_FLOATS * sizeof(float);
+    /**
+     * @brief Creates another VAO over the shared buffers, for users that add attributes of their own (e.g. instance data).
+     * The new VAO is left bound so the caller can keep adding attributes.
+     * @return The new VAO.
+     */
+    GLuint create_VAO() const;
+    /**
+     * @brief Draws the whole mesh with the currently bound VAO and program.
+     */
+    void draw() const;
+};
+
+GLuint gpu_mesh::create_VAO() const{
+    GLuint new_VAO;
+    glGenVertexArrays(1, &new_VAO);
+    glBindVertexArray(new_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    for(const mesh_file_attribute& attribute : layout){
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(attribute.location, GLint(attribute.components), GLenum(attribute.type), GL_FALSE, vertex_stride,
+            (void*)size_t(attribute.offset));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return new_VAO;
+}
+
+void gpu_mesh::draw() const{
+    glDrawElements(GL_TRIANGLES, index_count, index_type, (void*)0);
+}
+
+/**
+ * @brief A mesh file mapped into memory, whose submeshes are uploaded the first time they are asked for.
+ * Opening only reads the header and the tables; a submesh's vertices and indices are handed to glBufferData straight
+ * from the mapping, so only the pages of the submeshes that are drawn are ever read. The file is unmapped once every
+ * submesh is uploaded.
+ */
+class mesh_asset{
+public:
+    /**
+     * @brief Maps a mesh file and reads its tables.
+     * @param path The path of the .mesh file.
+     * @return False if the file is missing or is not a valid mesh file of this version.
+     */
+    bool open(const std::string& path);
+    /**
+     * @brief Returns the number of submeshes in the file.
+     */
+    int submesh_count() const;
+    /**
+     * @brief Returns the model space bounding sphere of a submesh without uploading it, for culling.
+     * @param index The submesh index.
+     */
+    const bounding_sphere& submesh_bounds(int index) const;
+    /**
+     * @brief Returns the model space bounding sphere of the whole mesh.
+     */
+    const bounding_sphere& bounds() const;
+    /**
+     * @brief Returns a submesh, uploading it on first use. Its indices are checked before the upload.
+     * @param index The submesh index.
+     * @return The GPU mesh, it stays valid until the context is destroyed, or nullptr if an index of the submesh
+     * points past its vertices.
+     */
+    const gpu_mesh* submesh(int index);
+    /**
+     * @brief Returns the number of submeshes uploaded so far.
+     */
+    int uploaded_submeshes() const;
+private:
+    mapped_file file;
+    mesh_file_view view;
+    std::vector<gpu_mesh> submeshes; // VAO 0 until uploaded
+    std::vector<bool> rejected; // submeshes whose indices failed the check
+    bounding_sphere whole_bounds;
+    int uploaded = 0;
+    int rejected_count = 0;
+};
+
+bool mesh_asset::open(const std::string& path){
+    if(!file.open(path) || !view.open(file.data(), file.size()) || view.header().submesh_count == 0){
+        file.close();
+        return false;
+    }
+    const mesh_file_header& header = view.header();
+    whole_bounds.center = glm::vec3(header.bounds_center[0], header.bounds_center[1], header.bounds_center[2]);
+    whole_bounds.radius = header.bounds_radius;
+    std::vector<mesh_file_attribute> layout(view.attributes(), view.attributes() + header.attribute_count);
+    submeshes.resize(header.submesh_count);
+    rejected.assign(header.submesh_count, false);
+    for(uint32_t i = 0; i < header.submesh_count; i++){
+        const mesh_file_submesh& entry = view.submesh(i);
+        gpu_mesh& mesh = submeshes[i];
+        mesh.index_count = GLsizei(entry.index_count);
+        mesh.vertex_count = GLsizei(entry.vertex_count);
+        mesh.index_type = header.index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        mesh.bounds.center = glm::vec3(entry.bounds_center[0], entry.bounds_center[1], entry.bounds_center[2]);
+        mesh.bounds.radius = entry.bounds_radius;
+        mesh.layout = layout;
+        mesh.vertex_stride = GLsizei(header.vertex_stride);
+    }
+    return true;
+}
+
+int mesh_asset::submesh_count() const{
+    return int(submeshes.size());
+}
+
+const bounding_sphere& mesh_asset::submesh_bounds(int index) const{
+    return submeshes[index].bounds;
+}
+
+const bounding_sphere& mesh_asset::bounds() const{
+    return whole_bounds;
+}
+
+const gpu_mesh* mesh_asset::submesh(int index){
+    gpu_mesh& mesh = submeshes[index];
+    if(mesh.VAO != 0){
+        return &mesh;
+    }
+    if(rejected[index]){
+        return nullptr;
+    }
+    if(!view.indices_in_range(uint32_t(index))){
+        std::cout << "Submesh " << index << " of a mesh file indexes past its vertices!!!" << std::endl;
+        rejected[index] = true;
+        rejected_count++;
+        if(uploaded + rejected_count == submesh_count()){
+            file.close();
+        }
+        return nullptr;
+    }
+    glGenBuffers(1, &mesh.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(size_t(mesh.vertex_count) * mesh.vertex_stride), view.vertices(uint32_t(index)), GL_STATIC_DRAW);
+    glGenBuffers(1, &mesh.EBO);
+    mesh.VAO = mesh.create_VAO();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(size_t(mesh.index_count) * view.header().index_size), view.indices(uint32_t(index)),
+        GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // glBufferData has copied the data, the mapping is only needed for the submeshes still to come
+    if(++uploaded + rejected_count == submesh_count()){
+        file.close();
+    }
+    return &mesh;
+}
+
+int mesh_asset::uploaded_submeshes() const{
+    return uploaded;
+}
+
+/**
+ * @brief Uploads each named mesh once and hands out the shared GPU copy afterwards.
+ * Meshes live until the context is destroyed, so references stay valid for the whole run.
+ */
+class mesh_registry{
+public:
+    /**
+     * @brief Returns the mesh registered under the name, generating and uploading it on first use.
+     * @param name The unique mesh name.
+     * @param generate Builds the mesh data, only called if the mesh is not uploaded yet.
+     * @return The shared GPU mesh.
+     */
+    const gpu_mesh& acquire(const std::string& name, const std::function<mesh_data()>& generate);
+    /**
+     * @brief Returns a mesh file written by the meshbake tool, mapping it on first use. Nothing is uploaded until a
+     * submesh is asked for.
+     * @param path The path of the .mesh file, it is also the name of the asset.
+     * @return The shared asset, or nullptr if the file is missing or invalid.
+     */
+    mesh_asset* load(const std::string& path);
+    /**
+     * @brief Returns the unit cube (edge length 1).
+     */
+    const gpu_mesh& cube();
+    /**
+     * @brief Returns the unit plane on the XZ axis facing +Y.
+     */
+    const gpu_mesh& plane();
+    /**
+     * @brief Returns the sphere with radius 0.5.
+     */
+    const gpu_mesh& sphere();
+    /**
+     * @brief Returns the number of meshes uploaded so far, counting each uploaded submesh of a mesh file.
+     */
+    int uploaded_meshes() const;
+private:
+    std::map<std::string, gpu_mesh> meshes;
+    std::map<std::string, mesh_asset> assets;
+};
+
+const gpu_mesh& mesh_registry::acquire(const std::string& name, const std::function<mesh_data()>& generate){
+    auto found = meshes.find(name);
+    if(found != meshes.end()){
+        return found->second;
+    }
+    mesh_data data = generate();
+    gpu_mesh& mesh = meshes[name];
+    mesh.index_count = GLsizei(data.indices.size());
+    mesh.vertex_count = GLsizei(data.vertex_count());
+    mesh.bounds = sphere_from_points(data.vertices.data() + MESH_POSITION_OFFSET, data.vertex_count(), MESH_VERTEX_FLOATS);
+
+    glGenBuffers(1, &mesh.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(float), data.vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &mesh.EBO);
+    // The element buffer is only recorded by a VAO, so bind it while one is bound
+    mesh.VAO = mesh.create_VAO();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return mesh;
+}
+
+mesh_asset* mesh_registry::load(const std::string& path){
+    auto found = assets.find(path);
+    if(found != assets.end()){
+        return &found->second;
+    }
+    mesh_asset& asset = assets[path];
+    if(!asset.open(path)){
+        assets.erase(path);
+        return nullptr;
+    }
+    return &asset;
+}
+
+const gpu_mesh& mesh_registry::cube(){
+    return acquire("cube", [](){ return generate_cube(1.0f); });
+}
+
+const gpu_mesh& mesh_registry::plane(){
+    return acquire("plane", [](){ return generate_plane(1.0f, 1.0f, 1); });
+}
+
+const gpu_mesh& mesh_registry::sphere(){
+    return acquire("sphere", [](){ return generate_sphere(0.5f, 32, 16); });
+}
+
+int mesh_registry::uploaded_meshes() const{
+    int count = int(meshes.size());
+    for(const auto& asset : assets){
+        count += asset.second.uploaded_submeshes();
+    }
+    return count;
+}
+
+/**
+ * @brief Returns the mesh registry shared by the whole application.
+ */
+mesh_registry& mesh_library(){
+    static mesh_registry registry;
+    return registry;
+}
+
+#endif
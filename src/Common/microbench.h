@@ -0,0 +1,284 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every case is calibrated to run at least this long per repetition
+const double MICROBENCH_DEFAULT_MIN_TIME_MS = 20.0;
+const int MICROBENCH_DEFAULT_REPETITIONS = 10;
+const int MICROBENCH_MAX_ITERATIONS = 1 << 30;
+
+/**
+ * @brief Allocations made through the global operator new, the harness reads them around every repetition.
+ * Cases that run on the job pool allocate from its workers too, so the counters are atomic.
+ */
+struct allocation_stats{
+    std::atomic<long long> allocations{0};
+    std::atomic<long long> bytes{0};
+};
+
+allocation_stats microbench_allocations;
+
+// Counting replacements of the global allocation functions, a benchmark target is a single translation unit
+void* operator new(size_t size){
+    microbench_allocations.allocations.fetch_add(1, std::memory_order_relaxed);
+    microbench_allocations.bytes.fetch_add((long long)size, std::memory_order_relaxed);
+    if(void* memory = std::malloc(size == 0 ? 1 : size)){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept{
+    std::free(memory);
+}
+
+/**
+ * @brief Keeps the compiler from optimizing away a value the benchmark computes but never uses.
+ * @param value The value.
+ */
+template<typename T>
+inline void keep(const T& value){
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief What a benchmark function gets: its input size and how many times to run the measured code.
+ * Setup before start() and after stop() is not timed.
+ */
+class bench_state{
+public:
+    int param;
+    int iterations;
+
+    bench_state(int param, int iterations) : param(param), iterations(iterations){}
+    /**
+     * @brief Starts the measured section.
+     */
+    void start();
+    /**
+     * @brief Ends the measured section.
+     */
+    void stop();
+    double elapsed_ns() const{ return elapsed; }
+    long long allocations() const{ return allocation_count; }
+    long long allocated_bytes() const{ return allocated; }
+private:
+    std::chrono::steady_clock::time_point start_time;
+    double elapsed = 0.0;
+    long long allocation_count = 0;
+    long long allocated = 0;
+    bool running = false;
+};
+
+void bench_state::start(){
+    allocation_count -= microbench_allocations.allocations.load(std::memory_order_relaxed);
+    allocated -= microbench_allocations.bytes.load(std::memory_order_relaxed);
+    running = true;
+    start_time = std::chrono::steady_clock::now();
+}
+
+void bench_state::stop(){
+    auto end_time = std::chrono::steady_clock::now();
+    if(!running){
+        return;
+    }
+    running = false;
+    elapsed += std::chrono::duration<double, std::nano>(end_time - start_time).count();
+    allocation_count += microbench_allocations.allocations.load(std::memory_order_relaxed);
+    allocated += microbench_allocations.bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief One registered benchmark, run once for every parameter.
+ */
+struct bench_case{
+    std::string name;
+    std::vector<int> params;
+    std::function<void(bench_state&)> function;
+};
+
+/**
+ * @brief The summary of every repetition of one benchmark and parameter, times are per iteration.
+ */
+struct bench_result{
+    std::string name;
+    int param;
+    int iterations;
+    double min_ns;
+    double mean_ns;
+    double median_ns;
+    double stddev_ns;
+    double max_ns;
+    double allocations;
+    double bytes;
+};
+
+/**
+ * @brief Registers, runs and reports the benchmarks of one target.
+ */
+class microbench_suite{
+public:
+    /**
+     * @brief Registers a benchmark.
+     * @param name The name, --filter matches substrings of it.
+     * @param params The input sizes, the function reads them from bench_state::param.
+     * @param function The benchmark, it has to run the measured code bench_state::iterations times between start() and stop().
+     */
+    void add(const std::string& name, const std::vector<int>& params, std::function<void(bench_state&)> function);
+    /**
+     * @brief Parses the command line and runs every matching benchmark, unknown arguments end the program with the usage.
+     * @return The exit code of the program.
+     */
+    int run(int argc, char** argv);
+private:
+    std::vector<bench_case> cases;
+
+    bench_result measure(const bench_case& bench, int param, int repetitions, double min_time_ms);
+};
+
+void microbench_suite::add(const std::string& name, const std::vector<int>& params, std::function<void(bench_state&)> function){
+    cases.push_back({name, params, function});
+}
+
+bench_result microbench_suite::measure(const bench_case& bench, int param, int repetitions, double min_time_ms){
+    // Warms up the caches and finds the iteration count that reaches the minimum time
+    int iterations = 1;
+    while(true){
+        bench_state state(param, iterations);
+        bench.function(state);
+        double elapsed_ms = state.elapsed_ns() / 1e6;
+        if(elapsed_ms >= min_time_ms || iterations >= MICROBENCH_MAX_ITERATIONS){
+            break;
+        }
+        double scale = elapsed_ms > 0.0 ? 1.4 * min_time_ms / elapsed_ms : 10.0;
+        iterations = int(std::min(double(MICROBENCH_MAX_ITERATIONS), std::max(iterations * 2.0, iterations * std::min(scale, 10.0))));
+    }
+
+    std::vector<double> times;
+    double allocations = 0.0;
+    double bytes = 0.0;
+    for(int repetition = 0; repetition < repetitions; repetition++){
+        bench_state state(param, iterations);
+        bench.function(state);
+        times.push_back(state.elapsed_ns() / iterations);
+        allocations += double(state.allocations()) / iterations;
+        bytes += double(state.allocated_bytes()) / iterations;
+    }
+    std::sort(times.begin(), times.end());
+    bench_result result;
+    result.name = bench.name;
+    result.param = param;
+    result.iterations = iterations;
+    result.min_ns = times.front();
+    result.max_ns = times.back();
+    result.median_ns = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+    double sum = 0.0;
+    for(double time : times){
+        sum += time;
+    }
+    result.mean_ns = sum / times.size();
+    double variance = 0.0;
+    for(double time : times){
+        variance += (time - result.mean_ns) * (time - result.mean_ns);
+    }
+    result.stddev_ns = times.size() > 1 ? std::sqrt(variance / (times.size() - 1)) : 0.0;
+    result.allocations = allocations / repetitions;
+    result.bytes = bytes / repetitions;
+    return result;
+}
+
+int microbench_suite::run(int argc, char** argv){
+    std::string filter;
+    std::string csv_path;
+    int repetitions = MICROBENCH_DEFAULT_REPETITIONS;
+    double min_time_ms = MICROBENCH_DEFAULT_MIN_TIME_MS;
+    bool list = false;
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if(argument == "--filter" && has_value){
+            filter = argv[++i];
+        }else if(argument == "--repetitions" && has_value && (repetitions = atoi(argv[i + 1])) > 0){
+            i++;
+        }else if(argument == "--min-time" && has_value && (min_time_ms = atof(argv[i + 1])) > 0.0){
+            i++;
+        }else if(argument == "--csv" && has_value){
+            csv_path = argv[++i];
+        }else if(argument == "--list"){
+            list = true;
+        }else{
+            printf("Usage: %s [--filter text] [--repetitions N] [--min-time MS] [--csv file.csv] [--list]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE* csv = NULL;
+    if(!csv_path.empty()){
+        csv = fopen(csv_path.c_str(), "w");
+        if(csv == NULL){
+            printf("Could not open %s for writing!\n", csv_path.c_str());
+            return 1;
+        }
+        fprintf(csv, "name,param,iterations,repetitions,min_ns,mean_ns,median_ns,stddev_ns,max_ns,allocations,bytes\n");
+    }
+    if(!list){
+        printf("%-40s %8s %10s %12s %12s %9s %10s %10s\n", "benchmark", "param", "iterations", "median ns", "mean ns", "stddev %", "allocs", "bytes");
+    }
+    for(const bench_case& bench : cases){
+        if(!filter.empty() && bench.name.find(filter) == std::string::npos){
+            continue;
+        }
+        for(int param : bench.params){
+            if(list){
+                printf("%s/%d\n", bench.name.c_str(), param);
+                continue;
+            }
+            bench_result result = measure(bench, param, repetitions, min_time_ms);
+            printf("%-40s %8d %10d %12.1f %12.1f %9.1f %10.2f %10.1f\n", result.name.c_str(), result.param, result.iterations,
+                result.median_ns, result.mean_ns, result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0,
+                result.allocations, result.bytes);
+            if(csv != NULL){
+                fprintf(csv, "%s,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.1f\n", result.name.c_str(), result.param, result.iterations,
+                    repetitions, result.min_ns, result.mean_ns, result.median_ns, result.stddev_ns, result.max_ns, result.allocations, result.bytes);
+                fflush(csv);
+            }
+        }
+    }
+    if(csv != NULL){
+        fclose(csv);
+    }
+    return 0;
+}
+
+#endif
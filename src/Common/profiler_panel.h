@@ -0,0 +1,55 @@
+#ifndef PROFILER_PANEL_H
+#define PROFILER_PANEL_H
+
+#include <cstdio>
+#include <imgui.h>
+#include "frame_profiler.h"
+
+/**
+ * @brief Draws the rolling graph and the min/avg/max and percentiles of one history.
+ * @param label The label of the graph, unique in the window.
+ * @param history The history.
+ */
+void draw_profile_history(const char* label, const profile_history& history){
+    profile_summary summary = history.summary();
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "%.3f ms", history.last());
+    ImGui::PlotLines(label, history.data(), history.size(), history.offset(), overlay, 0.0f, summary.max * 1.1f + 0.001f, ImVec2(0.0f, 40.0f));
+    ImGui::Text("min %.3f  avg %.3f  max %.3f  p50 %.3f  p95 %.3f  p99 %.3f", summary.min, summary.avg, summary.max,
+        summary.p50, summary.p95, summary.p99);
+}
+
+/**
+ * @brief Draws the profiler window: the frame totals, then every pass with its average times and, when expanded, its graphs.
+ * @param frame_profiler The profiler to show.
+ */
+void draw_profiler_window(const frame_profiler& frame_profiler){
+    // Opens in the top right corner, away from the control windows of the showcases
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 10.0f, 10.0f), ImGuiCond_FirstUseEver, ImVec2(1.0f, 0.0f));
+    ImGui::Begin("Profiler");
+    ImGui::Text("Last %d frames, times in ms", frame_profiler.frame_cpu().size());
+    draw_profile_history("Frame CPU", frame_profiler.frame_cpu());
+    if(frame_profiler.gpu_timing()){
+        draw_profile_history("Frame GPU", frame_profiler.frame_gpu());
+        ImGui::Text("GPU results are %d frames late, %d frames dropped", PROFILER_LATENCY, frame_profiler.dropped_frames());
+    }else{
+        ImGui::Text("No timer queries in this context, GPU times are not available");
+    }
+    ImGui::Separator();
+    for(const profile_pass& pass : frame_profiler.passes()){
+        profile_summary cpu = pass.cpu.summary();
+        profile_summary gpu = pass.gpu.summary();
+        if(ImGui::TreeNode(pass.name.c_str(), "%-20s CPU %7.3f  GPU %7.3f", pass.name.c_str(), cpu.avg, gpu.avg)){
+            ImGui::PushID(pass.name.c_str());
+            draw_profile_history("CPU", pass.cpu);
+            if(frame_profiler.gpu_timing()){
+                draw_profile_history("GPU", pass.gpu);
+            }
+            ImGui::PopID();
+            ImGui::TreePop();
+        }
+    }
+    ImGui::End();
+}
+
+#endif
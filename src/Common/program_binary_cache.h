@@ -0,0 +1,192 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "file_io.h"
+
+// Program binary file layout, native byte order: program_binary_header, then binary_size bytes of the binary
+const uint32_t PROGRAM_BINARY_MAGIC = 0x4E494250; // "PBIN"
+const uint32_t PROGRAM_BINARY_VERSION = 1;
+const char* const PROGRAM_BINARY_EXTENSION = ".progbin";
+
+/**
+ * @brief Header of a program binary file.
+ */
+struct program_binary_header{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key; // program_binary_cache::make_key() of the sources the binary was linked from
+    uint32_t binary_format; // as returned by glGetProgramBinary
+    uint32_t binary_size;
+};
+
+static_assert(sizeof(program_binary_header) == 24, "program_binary_header must not change layout");
+
+/**
+ * @brief On-disk cache of linked programs (ARB_get_program_binary), one file per program named after its key.
+ * The key hashes the shader sources together with the vendor, renderer and version strings of the driver, so a driver
+ * update or a changed shader simply misses. Binaries the driver rejects are counted as misses and replaced after the
+ * program is linked from source again. Without program binaries in the context every lookup misses and nothing is written.
+ */
+class program_binary_cache{
+public:
+    /**
+     * @brief Sets the folder the binaries are stored in, it is created on the first store.
+     * @param path The folder path.
+     */
+    void set_directory(const std::string& path);
+    /**
+     * @brief Returns the key of a program for the current driver.
+     * @param vertex_source The vertex shader source, with its defines injected.
+     * @param fragment_source The fragment shader source, with its defines injected.
+     */
+    uint64_t make_key(const std::string& vertex_source, const std::string& fragment_source);
+    /**
+     * @brief Creates a program from its cached binary.
+     * @param key The key of the program.
+     * @return The linked program, or 0 if there is no usable binary.
+     */
+    GLuint load(uint64_t key);
+    /**
+     * @brief Prepares a program that is about to be linked from source, so its binary can be retrieved afterwards.
+     * @param program The program, not linked yet.
+     */
+    void prepare(GLuint program);
+    /**
+     * @brief Writes the binary of a program linked from source.
+     * @param key The key of the program.
+     * @param program The linked program.
+     */
+    void store(uint64_t key, GLuint program);
+    /**
+     * @brief Returns false if the context cannot save or load program binaries.
+     */
+    bool supported();
+    int hits() const{ return hit_count; }
+    int misses() const{ return miss_count; }
+private:
+    std::string directory = "./res/ShaderCache";
+    std::string driver;
+    bool checked = false;
+    bool available = false;
+    int hit_count = 0;
+    int miss_count = 0;
+
+    std::string binary_path(uint64_t key) const;
+};
+
+void program_binary_cache::set_directory(const std::string& path){
+    directory = path;
+}
+
+bool program_binary_cache::supported(){
+    if(!checked){
+        checked = true;
+        GLint formats = 0;
+        if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary){
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        available = formats > 0;
+        const GLubyte* strings[] = {glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION)};
+        for(const GLubyte* string : strings){
+            driver += string != nullptr ? (const char*)string : "";
+            driver += '\n';
+        }
+    }
+    return available;
+}
+
+uint64_t program_binary_cache::make_key(const std::string& vertex_source, const std::string& fragment_source){
+    supported();
+    // The lengths keep "ab" + "c" apart from "a" + "bc"
+    uint64_t lengths[3] = {vertex_source.size(), fragment_source.size(), driver.size()};
+    uint64_t key = hash_bytes((const unsigned char*)lengths, sizeof(lengths));
+    key = hash_bytes((const unsigned char*)vertex_source.data(), vertex_source.size(), key);
+    key = hash_bytes((const unsigned char*)fragment_source.data(), fragment_source.size(), key);
+    return hash_bytes((const unsigned char*)driver.data(), driver.size(), key);
+}
+
+std::string program_binary_cache::binary_path(uint64_t key) const{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return directory + "/" + name + PROGRAM_BINARY_EXTENSION;
+}
+
+GLuint program_binary_cache::load(uint64_t key){
+    std::vector<unsigned char> bytes;
+    if(!supported() || !read_whole_file(binary_path(key), bytes) || bytes.size() < sizeof(program_binary_header)){
+        miss_count++;
+        return 0;
+    }
+    program_binary_header header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if(header.magic != PROGRAM_BINARY_MAGIC || header.version != PROGRAM_BINARY_VERSION || header.key != key
+        || header.binary_size != bytes.size() - sizeof(header)){
+        miss_count++;
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, GLenum(header.binary_format), bytes.data() + sizeof(header), GLsizei(header.binary_size));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(!linked){
+        glDeleteProgram(program);
+        miss_count++;
+        return 0;
+    }
+    hit_count++;
+    return program;
+}
+
+void program_binary_cache::prepare(GLuint program){
+    if(supported()){
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void program_binary_cache::store(uint64_t key, GLuint program){
+    GLint length = 0;
+    GLint linked = GL_FALSE;
+    if(!supported()){
+        return;
+    }
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(!linked || length <= 0){
+        return;
+    }
+    std::vector<unsigned char> bytes(sizeof(program_binary_header) + size_t(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, bytes.data() + sizeof(program_binary_header));
+    if(written <= 0){
+        return;
+    }
+    program_binary_header header;
+    header.magic = PROGRAM_BINARY_MAGIC;
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key;
+    header.binary_format = uint32_t(format);
+    header.binary_size = uint32_t(written);
+    memcpy(bytes.data(), &header, sizeof(header));
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    // An unwritable folder only costs the compilation on every launch
+    replace_file(binary_path(key), bytes.data(), sizeof(header) + size_t(written));
+}
+
+/**
+ * @brief Returns the program binary cache shared by the whole application.
+ */
+program_binary_cache& program_binaries(){
+    static program_binary_cache cache;
+    return cache;
+}
+
+#endif
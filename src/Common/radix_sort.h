@@ -0,0 +1,49 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief A 64-bit sort key and the index of the element it belongs to.
+ */
+struct sort_entry{
+    uint64_t key;
+    uint32_t index;
+};
+
+/**
+ * @brief Stable LSD radix sort on the keys, one byte per pass. Passes where every key has the same byte are skipped,
+ * so keys that only use a few of their bits cost only as many passes.
+ * @param entries The entries to sort, sorted in place.
+ * @param scratch Buffer of the same size reused between calls to avoid allocations.
+ */
+void radix_sort(std::vector<sort_entry>& entries, std::vector<sort_entry>& scratch){
+    size_t count = entries.size();
+    if(count < 2){
+        return;
+    }
+    scratch.resize(count);
+    for(int shift = 0; shift < 64; shift += 8){
+        size_t offsets[256] = {};
+        for(const sort_entry& entry : entries){
+            offsets[(entry.key >> shift) & 0xFF]++;
+        }
+        if(offsets[(entries[0].key >> shift) & 0xFF] == count){
+            continue;
+        }
+        size_t total = 0;
+        for(size_t& offset : offsets){
+            size_t bucket = offset;
+            offset = total;
+            total += bucket;
+        }
+        for(const sort_entry& entry : entries){
+            scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "gl_state_cache.h"
+#include "frame_profiler.h"
+#include "radix_sort.h"
+
+/**
+ * @brief Passes drawn in order. Opaque draws go front to back, transparent ones back to front.
+ */
+enum render_pass : uint8_t{
+    PASS_OPAQUE = 0,
+    PASS_TRANSPARENT = 1
+};
+
+/**
+ * @brief One draw call: the state it needs and the callback that sets its own uniforms and issues the draw.
+ * A texture of 0 leaves its unit untouched, both textures are bound to texture_target (e.g. GL_TEXTURE_2D_ARRAY).
+ */
+struct draw_item{
+    render_pass pass = PASS_OPAQUE;
+    GLuint program = 0;
+    GLuint VAO = 0;
+    GLuint texture1 = 0;
+    GLuint texture2 = 0;
+    GLenum texture_target = GL_TEXTURE_2D;
+    float depth = 0.0f; // distance from the camera
+    void (*issue)(void* object) = nullptr;
+    void* object = nullptr;
+    int profile_pass = -1; // profiler pass charged with issuing the draw, set by submit()
+};
+
+// Sort key layout from the most significant bit: pass (2), program (12), texture 1 (8), texture 2 (8), mesh (10), depth (24).
+// IDs are truncated to their low bits, a collision only costs an extra bind, never a wrong draw.
+const int SORT_KEY_DEPTH_BITS = 24;
+const int SORT_KEY_MESH_SHIFT = 24;
+const int SORT_KEY_TEXTURE2_SHIFT = 34;
+const int SORT_KEY_TEXTURE1_SHIFT = 42;
+const int SORT_KEY_PROGRAM_SHIFT = 50;
+const int SORT_KEY_PASS_SHIFT = 62;
+
+/**
+ * @brief Builds the sort key of a draw item, so that sorting the keys groups draws by program, then textures, then mesh.
+ * @param item The draw item.
+ * @param max_depth The depth mapped to the last depth bucket, farther draws share it.
+ * @return The 64-bit key.
+ */
+uint64_t make_sort_key(const draw_item& item, float max_depth){
+    const uint64_t depth_buckets = (uint64_t(1) << SORT_KEY_DEPTH_BITS) - 1;
+    float normalized = std::min(std::max(item.depth / max_depth, 0.0f), 1.0f);
+    uint64_t depth = uint64_t(normalized * float(depth_buckets));
+    if(item.pass == PASS_TRANSPARENT){
+        depth = depth_buckets - depth;
+    }
+    return (uint64_t(item.pass & 0x3) << SORT_KEY_PASS_SHIFT)
+        | (uint64_t(item.program & 0xFFF) << SORT_KEY_PROGRAM_SHIFT)
+        | (uint64_t(item.texture1 & 0xFF) << SORT_KEY_TEXTURE1_SHIFT)
+        | (uint64_t(item.texture2 & 0xFF) << SORT_KEY_TEXTURE2_SHIFT)
+        | (uint64_t(item.VAO & 0x3FF) << SORT_KEY_MESH_SHIFT)
+        | depth;
+}
+
+/**
+ * @brief Collects the draws of a frame, radix sorts them by key and issues them through the GL state cache.
+ */
+class render_queue{
+public:
+    /**
+     * @brief Drops the draws of the previous frame.
+     * @param max_depth The far plane, used to quantize the draw depths.
+     */
+    void begin(float max_depth);
+    /**
+     * @brief Adds a draw to this frame, charged to the profiler pass that is active while it is submitted.
+     * @param item The draw item.
+     */
+    void submit(const draw_item& item);
+    /**
+     * @brief Sorts the draws and issues them, binding only the state that changes between consecutive draws.
+     * Every run of draws from the same profiler pass is timed as a segment of that pass.
+     */
+    void flush();
+    /**
+     * @brief Issues the queued draws like flush() but with the scissor test closed, then drops them. Drivers that build
+     * shader variants for the state of the first draw with a program (vertex layout, textures, depth test) do it here
+     * instead of during the first frames, nothing reaches the framebuffer.
+     */
+    void warm_up();
+    /**
+     * @brief Returns the number of draws submitted this frame.
+     */
+    int size() const;
+private:
+    float depth_range = 100.0f;
+    std::vector<draw_item> items;
+    std::vector<sort_entry> keys;
+    std::vector<sort_entry> scratch;
+};
+
+void render_queue::begin(float max_depth){
+    depth_range = max_depth;
+    items.clear();
+}
+
+void render_queue::submit(const draw_item& item){
+    items.push_back(item);
+    items.back().profile_pass = profiler().active_pass();
+}
+
+void render_queue::flush(){
+    keys.resize(items.size());
+    for(size_t i = 0; i < items.size(); i++){
+        keys[i].key = make_sort_key(items[i], depth_range);
+        keys[i].index = uint32_t(i);
+    }
+    radix_sort(keys, scratch);
+    gl_state_cache& state = gl_state();
+    int profile_pass = -1;
+    for(const sort_entry& entry : keys){
+        const draw_item& item = items[entry.index];
+        if(item.profile_pass != profile_pass){
+            profile_pass = item.profile_pass;
+            if(profile_pass >= 0){
+                profiler().begin(profile_pass);
+            }else{
+                profiler().end();
+            }
+        }
+        state.use_program(item.program);
+        state.bind_vertex_array(item.VAO);
+        if(item.texture1 != 0){
+            state.bind_texture(0, item.texture_target, item.texture1);
+        }
+        if(item.texture2 != 0){
+            state.bind_texture(1, item.texture_target, item.texture2);
+        }
+        item.issue(item.object);
+    }
+    if(profile_pass >= 0){
+        profiler().end();
+    }
+}
+
+void render_queue::warm_up(){
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, 0, 0);
+    flush();
+    glDisable(GL_SCISSOR_TEST);
+    // The variants are built by the time the draws are done
+    glFinish();
+    items.clear();
+}
+
+int render_queue::size() const{
+    return int(items.size());
+}
+
+#endif
@@ -0,0 +1,574 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "bounding_volume.h"
+#include "job_system.h"
+
+// Queries answered by a single job of a batch query, and spheres rehashed by a single job of a batch update
+const int SPATIAL_GRID_GRAIN = 256;
+// Marks a free slot of the cell table, keys only use the low 63 bits
+const uint64_t SPATIAL_GRID_NO_KEY = UINT64_MAX;
+// Ends the list of chunks of a cell
+const uint32_t SPATIAL_GRID_NO_CHUNK = UINT32_MAX;
+// Spheres stored together in one chunk of a cell, enough for most cells to fit in one
+const int SPATIAL_GRID_CHUNK_SIZE = 8;
+
+/**
+ * @brief Loose uniform grid over bounding spheres, hashed so that it covers an unbounded world with memory for the
+ * occupied cells only. Every sphere lives in the one cell that holds its center, so moving it is a key comparison
+ * and, when it crosses into another cell, one unlink and relink; queries widen their cell range by the largest radius
+ * stored instead. With a cell size around the size of the objects a query only looks at a handful of cells, however
+ * many objects the grid holds. The cells are found through an open addressing table, and the spheres of a cell are
+ * stored in a list of fixed size chunks, so that a query reads them in a row. Cells and chunks come from pools, the
+ * ones that empty out are reused by the next that get occupied. Once reserve() has sized the records, the table and
+ * the pools, spheres coming, going and moving allocate nothing.
+ * Ids are small integers chosen by the caller (e.g. entity slots), the grid keeps one record per id up to the largest.
+ */
+class spatial_grid{
+public:
+    /**
+     * @brief Creates an empty grid.
+     * @param cell_size The edge length of a cell, best around twice the radius of a typical object.
+     */
+    explicit spatial_grid(float cell_size = 4.0f);
+    /**
+     * @brief Adds a sphere. The id must not be in the grid already.
+     * @param id The id of the object.
+     * @param sphere Its world space bounds.
+     */
+    void insert(uint32_t id, const bounding_sphere& sphere);
+    /**
+     * @brief Moves a sphere already in the grid.
+     * @param id The id of the object.
+     * @param sphere Its new world space bounds.
+     */
+    void update(uint32_t id, const bounding_sphere& sphere);
+    /**
+     * @brief Moves many spheres already in the grid. The new cells are found on every core, then only the spheres that
+     * changed cell are moved.
+     * @param ids The ids of the objects, each at most once.
+     * @param spheres Their new world space bounds.
+     * @param count The number of objects.
+     */
+    void update(const uint32_t* ids, const bounding_sphere* spheres, int count);
+    /**
+     * @brief Removes a sphere, ids not in the grid are ignored.
+     * @param id The id of the object.
+     */
+    void remove(uint32_t id);
+    /**
+     * @brief Removes every sphere.
+     */
+    void clear();
+    /**
+     * @brief Makes room for ids up to capacity - 1 and as many occupied cells, so that inserting them allocates nothing.
+     * @param capacity The number of ids.
+     */
+    void reserve(int capacity);
+    /**
+     * @brief Finds the spheres that touch a query sphere.
+     * @param center The center of the query.
+     * @param radius The radius of the query.
+     * @param ids Receives the ids of the spheres found, appended in no particular order.
+     */
+    void query_sphere(const glm::vec3& center, float radius, std::vector<uint32_t>& ids) const;
+    /**
+     * @brief Runs many sphere queries on every core.
+     * @param queries The query spheres.
+     * @param count The number of queries.
+     * @param ids Receives the ids found by every query, the ones of query i at [offsets[i], offsets[i + 1]).
+     * @param offsets Receives count + 1 offsets into ids.
+     */
+    void query_spheres(const bounding_sphere* queries, int count, std::vector<uint32_t>& ids, std::vector<int>& offsets) const;
+    /**
+     * @brief Finds the first sphere along a ray, walking the cells it crosses in order until a hit is certain.
+     * @param origin The start of the ray.
+     * @param direction The direction of the ray, it does not have to be normalized.
+     * @param max_distance The length of the ray.
+     * @param id Receives the id of the sphere hit.
+     * @param distance Receives the distance along the ray to the hit, 0 if the origin is inside the sphere.
+     * @return False if the ray hits nothing.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t& id, float& distance) const;
+    /**
+     * @brief Returns the number of spheres in the grid.
+     */
+    int size() const;
+    /**
+     * @brief Returns the number of occupied cells.
+     */
+    int cell_count() const;
+private:
+    struct record{
+        uint64_t key;
+        uint32_t cell; // index in cell_pool
+        uint32_t chunk; // index in chunk_pool and slot in it of the sphere
+        uint32_t slot;
+        bool used;
+    };
+    struct cell_entry{
+        uint64_t key; // SPATIAL_GRID_NO_KEY while the cell is spare
+        uint32_t first; // the only chunk of the cell's list that may not be full
+    };
+    struct slot_entry{
+        bounding_sphere sphere;
+        uint32_t id;
+    };
+    struct chunk{
+        uint32_t size; // 0 while the chunk is spare
+        uint32_t next;
+        slot_entry slots[SPATIAL_GRID_CHUNK_SIZE]; // each id next to its sphere, a chunk of a few spheres is one cache line
+    };
+    glm::ivec3 cell_of(const glm::vec3& point) const;
+    static uint64_t key_of(const glm::ivec3& cell);
+    static size_t hash_of(uint64_t key);
+    void unlink(uint32_t id);
+    void link(uint32_t id, uint64_t key, const bounding_sphere& sphere);
+    /**
+     * @brief Returns the index in cell_pool of the occupied cell with the key, or -1.
+     */
+    int find_cell(uint64_t key) const;
+    /**
+     * @brief Takes a spare cell, or makes a new one, for the key and adds it to the table.
+     */
+    uint32_t acquire_cell(uint64_t key);
+    /**
+     * @brief Removes an emptied cell from the table and makes it spare.
+     */
+    void release_cell(uint32_t cell);
+    /**
+     * @brief Rebuilds the table with at least twice as many slots as cells, if it has fewer.
+     */
+    void grow_table(size_t cells);
+    /**
+     * @brief Takes a spare chunk, or makes a new one, with no spheres.
+     */
+    uint32_t acquire_chunk();
+    /**
+     * @brief Calls visit with the id and the sphere of every sphere in the grid.
+     */
+    template<typename Visit>
+    void for_each_sphere(Visit visit) const;
+    /**
+     * @brief Calls visit with the id and the sphere of every sphere in the cells in [low, high], or of every sphere if
+     * the pool has fewer chunks than the range has cells.
+     */
+    template<typename Visit>
+    void for_each_in_cells(const glm::ivec3& low, const glm::ivec3& high, Visit visit) const;
+
+    float cell_size;
+    float inverse_cell_size;
+    float max_radius = 0.0f; // never shrinks, it only widens the queries
+    int count = 0;
+    std::vector<record> records; // indexed by id
+    std::vector<cell_entry> cell_pool; // occupied and spare cells
+    std::vector<uint32_t> spare_cells; // indices of the empty cells of the pool, not in the table
+    std::vector<chunk> chunk_pool; // chunks of the occupied cells and spare chunks
+    std::vector<uint32_t> spare_chunks;
+    std::vector<uint64_t> table_keys; // linear probing, power of two size, SPATIAL_GRID_NO_KEY marks a free slot
+    std::vector<uint32_t> table_cells; // index in cell_pool of each key
+    std::vector<uint64_t> new_keys; // scratch of the batch update
+};
+
+spatial_grid::spatial_grid(float size) : cell_size(size), inverse_cell_size(1.0f / size){}
+
+glm::ivec3 spatial_grid::cell_of(const glm::vec3& point) const{
+    return glm::ivec3(glm::floor(point * inverse_cell_size));
+}
+
+uint64_t spatial_grid::key_of(const glm::ivec3& cell){
+    // 21 bits per axis, cells repeat every 2^21 cells which no scene comes close to
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return ((uint64_t(uint32_t(cell.x)) & mask) << 42) | ((uint64_t(uint32_t(cell.y)) & mask) << 21) | (uint64_t(uint32_t(cell.z)) & mask);
+}
+
+size_t spatial_grid::hash_of(uint64_t key){
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    return size_t(hash ^ (hash >> 32));
+}
+
+int spatial_grid::find_cell(uint64_t key) const{
+    if(table_keys.empty()){
+        return -1;
+    }
+    size_t mask = table_keys.size() - 1;
+    for(size_t i = hash_of(key) & mask; table_keys[i] != SPATIAL_GRID_NO_KEY; i = (i + 1) & mask){
+        if(table_keys[i] == key){
+            return int(table_cells[i]);
+        }
+    }
+    return -1;
+}
+
+void spatial_grid::grow_table(size_t cells){
+    size_t size = 16;
+    while(size < cells * 2){
+        size *= 2;
+    }
+    if(size <= table_keys.size()){
+        return;
+    }
+    table_keys.assign(size, SPATIAL_GRID_NO_KEY);
+    table_cells.assign(size, 0);
+    size_t mask = size - 1;
+    for(uint32_t cell = 0; cell < uint32_t(cell_pool.size()); cell++){
+        uint64_t key = cell_pool[cell].key;
+        if(key == SPATIAL_GRID_NO_KEY){
+            continue;
+        }
+        size_t i = hash_of(key) & mask;
+        while(table_keys[i] != SPATIAL_GRID_NO_KEY){
+            i = (i + 1) & mask;
+        }
+        table_keys[i] = key;
+        table_cells[i] = cell;
+    }
+}
+
+uint32_t spatial_grid::acquire_cell(uint64_t key){
+    size_t occupied = cell_pool.size() - spare_cells.size();
+    if((occupied + 1) * 2 > table_keys.size()){
+        grow_table(std::max(occupied + 1, table_keys.size()));
+    }
+    uint32_t cell;
+    if(!spare_cells.empty()){
+        cell = spare_cells.back();
+        spare_cells.pop_back();
+    }else{
+        cell = uint32_t(cell_pool.size());
+        cell_pool.push_back(cell_entry{SPATIAL_GRID_NO_KEY, SPATIAL_GRID_NO_CHUNK});
+    }
+    cell_pool[cell].key = key;
+    size_t mask = table_keys.size() - 1;
+    size_t i = hash_of(key) & mask;
+    while(table_keys[i] != SPATIAL_GRID_NO_KEY){
+        i = (i + 1) & mask;
+    }
+    table_keys[i] = key;
+    table_cells[i] = cell;
+    return cell;
+}
+
+void spatial_grid::release_cell(uint32_t cell){
+    size_t mask = table_keys.size() - 1;
+    size_t hole = hash_of(cell_pool[cell].key) & mask;
+    while(table_cells[hole] != cell || table_keys[hole] == SPATIAL_GRID_NO_KEY){
+        hole = (hole + 1) & mask;
+    }
+    // Backward shift deletion: every key after the hole that may sit closer to its home slot moves into it
+    for(size_t i = (hole + 1) & mask; table_keys[i] != SPATIAL_GRID_NO_KEY; i = (i + 1) & mask){
+        size_t home = hash_of(table_keys[i]) & mask;
+        if(((i - home) & mask) >= ((i - hole) & mask)){
+            table_keys[hole] = table_keys[i];
+            table_cells[hole] = table_cells[i];
+            hole = i;
+        }
+    }
+    table_keys[hole] = SPATIAL_GRID_NO_KEY;
+    cell_pool[cell].key = SPATIAL_GRID_NO_KEY;
+    spare_cells.push_back(cell);
+}
+
+uint32_t spatial_grid::acquire_chunk(){
+    uint32_t index;
+    if(!spare_chunks.empty()){
+        index = spare_chunks.back();
+        spare_chunks.pop_back();
+    }else{
+        index = uint32_t(chunk_pool.size());
+        chunk_pool.emplace_back();
+    }
+    chunk_pool[index].size = 0;
+    chunk_pool[index].next = SPATIAL_GRID_NO_CHUNK;
+    return index;
+}
+
+void spatial_grid::link(uint32_t id, uint64_t key, const bounding_sphere& sphere){
+    int found = find_cell(key);
+    uint32_t cell = found >= 0 ? uint32_t(found) : acquire_cell(key);
+    uint32_t first = cell_pool[cell].first;
+    if(first == SPATIAL_GRID_NO_CHUNK || chunk_pool[first].size == SPATIAL_GRID_CHUNK_SIZE){
+        uint32_t added = acquire_chunk();
+        chunk_pool[added].next = first;
+        cell_pool[cell].first = first = added;
+    }
+    chunk& head = chunk_pool[first];
+    uint32_t slot = head.size++;
+    head.slots[slot] = slot_entry{sphere, id};
+    record& linked = records[id];
+    linked.key = key;
+    linked.cell = cell;
+    linked.chunk = first;
+    linked.slot = slot;
+}
+
+void spatial_grid::unlink(uint32_t id){
+    const record& linked = records[id];
+    cell_entry& entry = cell_pool[linked.cell];
+    // The last sphere of the first chunk fills the hole, so only the first chunk is ever partly full
+    chunk& head = chunk_pool[entry.first];
+    uint32_t last = head.size - 1;
+    uint32_t moved = head.slots[last].id;
+    chunk_pool[linked.chunk].slots[linked.slot] = head.slots[last];
+    records[moved].chunk = linked.chunk;
+    records[moved].slot = linked.slot;
+    head.size = last;
+    if(last == 0){
+        spare_chunks.push_back(entry.first);
+        entry.first = head.next;
+        if(entry.first == SPATIAL_GRID_NO_CHUNK){
+            release_cell(linked.cell);
+        }
+    }
+}
+
+void spatial_grid::insert(uint32_t id, const bounding_sphere& sphere){
+    if(id >= records.size()){
+        records.resize(size_t(id) + 1, record{0, 0, 0, 0, false});
+    }
+    records[id].used = true;
+    link(id, key_of(cell_of(sphere.center)), sphere);
+    max_radius = std::max(max_radius, sphere.radius);
+    count++;
+}
+
+void spatial_grid::update(uint32_t id, const bounding_sphere& sphere){
+    const record& entry = records[id];
+    chunk_pool[entry.chunk].slots[entry.slot].sphere = sphere;
+    max_radius = std::max(max_radius, sphere.radius);
+    uint64_t key = key_of(cell_of(sphere.center));
+    if(key != entry.key){
+        unlink(id);
+        link(id, key, sphere);
+    }
+}
+
+void spatial_grid::update(const uint32_t* ids, const bounding_sphere* spheres, int update_count){
+    new_keys.resize(update_count);
+    // Every id, and so every slot, is written by one range only, the chunks are left alone until the serial pass
+    job_pool().parallel_for(update_count, SPATIAL_GRID_GRAIN, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            const record& entry = records[ids[i]];
+            chunk_pool[entry.chunk].slots[entry.slot].sphere = spheres[i];
+            new_keys[i] = key_of(cell_of(spheres[i].center));
+        }
+    });
+    for(int i = 0; i < update_count; i++){
+        max_radius = std::max(max_radius, spheres[i].radius);
+        if(new_keys[i] != records[ids[i]].key){
+            unlink(ids[i]);
+            link(ids[i], new_keys[i], spheres[i]);
+        }
+    }
+}
+
+void spatial_grid::remove(uint32_t id){
+    if(id >= records.size() || !records[id].used){
+        return;
+    }
+    unlink(id);
+    records[id].used = false;
+    count--;
+}
+
+void spatial_grid::reserve(int capacity){
+    records.reserve(size_t(capacity));
+    new_keys.reserve(size_t(capacity));
+    grow_table(size_t(capacity));
+    cell_pool.reserve(size_t(capacity));
+    spare_cells.reserve(size_t(capacity));
+    while(cell_pool.size() < size_t(capacity)){
+        spare_cells.push_back(uint32_t(cell_pool.size()));
+        cell_pool.push_back(cell_entry{SPATIAL_GRID_NO_KEY, SPATIAL_GRID_NO_CHUNK});
+    }
+    // Every chunk in use holds at least one sphere, so there are never more of them than spheres
+    chunk_pool.reserve(size_t(capacity));
+    spare_chunks.reserve(size_t(capacity));
+    while(chunk_pool.size() < size_t(capacity)){
+        spare_chunks.push_back(uint32_t(chunk_pool.size()));
+        chunk_pool.emplace_back();
+        chunk_pool.back().size = 0;
+    }
+}
+
+void spatial_grid::clear(){
+    records.clear();
+    spare_cells.clear();
+    for(uint32_t cell = 0; cell < uint32_t(cell_pool.size()); cell++){
+        cell_pool[cell].key = SPATIAL_GRID_NO_KEY;
+        cell_pool[cell].first = SPATIAL_GRID_NO_CHUNK;
+        spare_cells.push_back(cell);
+    }
+    spare_chunks.clear();
+    for(uint32_t index = 0; index < uint32_t(chunk_pool.size()); index++){
+        chunk_pool[index].size = 0;
+        spare_chunks.push_back(index);
+    }
+    std::fill(table_keys.begin(), table_keys.end(), SPATIAL_GRID_NO_KEY);
+    max_radius = 0.0f;
+    count = 0;
+}
+
+template<typename Visit>
+void spatial_grid::for_each_sphere(Visit visit) const{
+    // Spare chunks have no spheres, visiting them costs nothing
+    for(const chunk& block : chunk_pool){
+        for(uint32_t i = 0; i < block.size; i++){
+            visit(block.slots[i].id, block.slots[i].sphere);
+        }
+    }
+}
+
+template<typename Visit>
+void spatial_grid::for_each_in_cells(const glm::ivec3& low, const glm::ivec3& high, Visit visit) const{
+    glm::i64vec3 extent = glm::i64vec3(high) - glm::i64vec3(low) + glm::i64vec3(1);
+    if(extent.x * extent.y * extent.z > int64_t(chunk_pool.size())){
+        for_each_sphere(visit);
+        return;
+    }
+    for(int x = low.x; x <= high.x; x++){
+        for(int y = low.y; y <= high.y; y++){
+            for(int z = low.z; z <= high.z; z++){
+                int cell = find_cell(key_of(glm::ivec3(x, y, z)));
+                if(cell < 0){
+                    continue;
+                }
+                for(uint32_t index = cell_pool[cell].first; index != SPATIAL_GRID_NO_CHUNK; index = chunk_pool[index].next){
+                    const chunk& block = chunk_pool[index];
+                    for(uint32_t i = 0; i < block.size; i++){
+                        visit(block.slots[i].id, block.slots[i].sphere);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void spatial_grid::query_sphere(const glm::vec3& center, float radius, std::vector<uint32_t>& ids) const{
+    if(count == 0){
+        return;
+    }
+    glm::vec3 reach(radius + max_radius);
+    for_each_in_cells(cell_of(center - reach), cell_of(center + reach), [&](uint32_t id, const bounding_sphere& sphere){
+        glm::vec3 offset = sphere.center - center;
+        float touching = sphere.radius + radius;
+        if(glm::dot(offset, offset) <= touching * touching){
+            ids.push_back(id);
+        }
+    });
+}
+
+void spatial_grid::query_spheres(const bounding_sphere* queries, int query_count, std::vector<uint32_t>& ids, std::vector<int>& offsets) const{
+    offsets.assign(size_t(query_count) + 1, 0);
+    // Every range collects its results on its own, they are put back in query order at the end
+    std::vector<std::pair<int, std::vector<uint32_t>>> ranges;
+    std::mutex ranges_lock;
+    job_pool().parallel_for(query_count, SPATIAL_GRID_GRAIN, [&](int begin, int end){
+        std::vector<uint32_t> found;
+        for(int i = begin; i < end; i++){
+            size_t before = found.size();
+            query_sphere(queries[i].center, queries[i].radius, found);
+            offsets[i + 1] = int(found.size() - before);
+        }
+        std::lock_guard<std::mutex> guard(ranges_lock);
+        ranges.emplace_back(begin, std::move(found));
+    });
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+    ids.clear();
+    for(const auto& range : ranges){
+        ids.insert(ids.end(), range.second.begin(), range.second.end());
+    }
+    for(int i = 0; i < query_count; i++){
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+bool spatial_grid::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t& id, float& distance) const{
+    if(count == 0 || glm::dot(direction, direction) == 0.0f){
+        return false;
+    }
+    glm::vec3 dir = glm::normalize(direction);
+    // A sphere can reach this many cells past the one holding its center
+    int ring = int(std::ceil(max_radius * inverse_cell_size));
+    glm::ivec3 cell = cell_of(origin);
+    glm::ivec3 step;
+    glm::vec3 next_boundary, boundary_spacing;
+    const float infinity = std::numeric_limits<float>::infinity();
+    for(int axis = 0; axis < 3; axis++){
+        if(dir[axis] > 0.0f){
+            step[axis] = 1;
+            next_boundary[axis] = ((cell[axis] + 1) * cell_size - origin[axis]) / dir[axis];
+            boundary_spacing[axis] = cell_size / dir[axis];
+        }else if(dir[axis] < 0.0f){
+            step[axis] = -1;
+            next_boundary[axis] = (cell[axis] * cell_size - origin[axis]) / dir[axis];
+            boundary_spacing[axis] = -cell_size / dir[axis];
+        }else{
+            step[axis] = 0;
+            next_boundary[axis] = infinity;
+            boundary_spacing[axis] = infinity;
+        }
+    }
+    float best = infinity;
+    auto test = [&](uint32_t candidate, const bounding_sphere& sphere){
+        glm::vec3 offset = origin - sphere.center;
+        float b = glm::dot(offset, dir);
+        float c = glm::dot(offset, offset) - sphere.radius * sphere.radius;
+        float discriminant = b * b - c;
+        if(discriminant < 0.0f){
+            return;
+        }
+        float root = std::sqrt(discriminant);
+        float hit = -b - root >= 0.0f ? -b - root : (-b + root >= 0.0f ? 0.0f : -1.0f);
+        if(hit >= 0.0f && hit <= max_distance && hit < best){
+            best = hit;
+            id = candidate;
+        }
+    };
+    // With fewer spheres than a neighbourhood has cells, testing every sphere once is cheaper than any walk
+    int64_t neighbourhood = int64_t(2 * ring + 1) * (2 * ring + 1) * (2 * ring + 1);
+    if(neighbourhood > int64_t(count)){
+        for_each_sphere(test);
+        distance = best;
+        return best != infinity;
+    }
+    for_each_in_cells(cell - glm::ivec3(ring), cell + glm::ivec3(ring), test);
+    float cell_enter = 0.0f;
+    // Every point of the ray up to cell_enter lies in a visited cell, and a sphere it touches is centered within the ring
+    // of that cell, so once the best hit comes before cell_enter nothing further along can beat it.
+    // The neighbourhood only ever moves forward along each axis, so after a step only the slab of cells entering it on
+    // the leading side is new: every cell is visited and every sphere tested once.
+    while(true){
+        int axis = next_boundary.x < next_boundary.y ? (next_boundary.x < next_boundary.z ? 0 : 2) : (next_boundary.y < next_boundary.z ? 1 : 2);
+        cell_enter = next_boundary[axis];
+        if(cell_enter > max_distance || cell_enter > best){
+            break;
+        }
+        cell[axis] += step[axis];
+        next_boundary[axis] += boundary_spacing[axis];
+        glm::ivec3 low = cell - glm::ivec3(ring);
+        glm::ivec3 high = cell + glm::ivec3(ring);
+        low[axis] = high[axis] = cell[axis] + step[axis] * ring;
+        for_each_in_cells(low, high, test);
+    }
+    distance = best;
+    return best != infinity;
+}
+
+int spatial_grid::size() const{
+    return count;
+}
+
+int spatial_grid::cell_count() const{
+    return int(cell_pool.size() - spare_cells.size());
+}
+
+#endif
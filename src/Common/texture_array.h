@@ -0,0 +1,89 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gl_state_cache.h"
+#include "texture_loader.h"
+
+/**
+ * @brief A GL_TEXTURE_2D_ARRAY holding same-size images, one per layer, so draws with different images bind the same
+ * texture and pick their image with a layer index. Images of another size are resampled to the array size while they
+ * are loaded. The layers are streamed in by texture_library() and show a grey placeholder until then.
+ */
+class texture_array{
+public:
+    /**
+     * @brief Allocates every mip level of the array with the wrapping and filtering of the showcase materials.
+     * @param layer_width The width every image is resampled to.
+     * @param layer_height The height every image is resampled to.
+     * @param capacity The number of layers.
+     */
+    void create(int layer_width, int layer_height, int capacity);
+    /**
+     * @brief Requests an image into the next free layer.
+     * @param path Path to the image file.
+     * @return The layer of the image, or -1 if the array is full.
+     */
+    int add(const std::string& path);
+    /**
+     * @brief Returns the ID of the GL_TEXTURE_2D_ARRAY.
+     */
+    GLuint id() const{ return texture; }
+    /**
+     * @brief Returns the number of layers in use.
+     */
+    int size() const{ return layer_count; }
+private:
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    int layer_capacity = 0;
+    int layer_count = 0;
+};
+
+void texture_array::create(int layer_width, int layer_height, int capacity){
+    width = layer_width;
+    height = layer_height;
+    layer_capacity = capacity;
+    layer_count = 0;
+    glGenTextures(1, &texture);
+    gl_state().bind_texture(0, GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The levels match the ones lay_out_texture_cache() gives the resampled images. Every level starts grey, the
+    // storage is specified once before the array is ever sampled and the layers are only replaced in place afterwards.
+    int level = 0;
+    int level_width = width;
+    int level_height = height;
+    std::vector<unsigned char> placeholder(size_t(width) * height * capacity * 4, 128);
+    for(size_t alpha = 3; alpha < placeholder.size(); alpha += 4){
+        placeholder[alpha] = 255;
+    }
+    while(true){
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, level_width, level_height, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+        if((level_width == 1 && level_height == 1) || level + 1 == int(TEXTURE_CACHE_MAX_LEVELS)){
+            break;
+        }
+        level++;
+        level_width = std::max(level_width / 2, 1);
+        level_height = std::max(level_height / 2, 1);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, level);
+}
+
+int texture_array::add(const std::string& path){
+    if(layer_count == layer_capacity){
+        std::cout << "The texture array is full, " << path << " is not loaded!!!" << std::endl;
+        return -1;
+    }
+    texture_library().request_layer(path, texture, layer_count, width, height);
+    return layer_count++;
+}
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+// A second include would compile the implementation again in the translation unit that defines STB_IMAGE_IMPLEMENTATION
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image.h>
+#endif
+#include "file_io.h"
+#include "mapped_file.h"
+
+// Cache file layout, native byte order: texture_cache_header, level_count texture_cache_level entries, then the pixels
+// of every level, largest first. Rows are padded to 4 bytes, so the default GL_UNPACK_ALIGNMENT reads them.
+const uint32_t TEXTURE_CACHE_MAGIC = 0x43585454; // "TTXC"
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+const uint32_t TEXTURE_CACHE_MAX_LEVELS = 16;
+const char* const TEXTURE_CACHE_EXTENSION = ".texcache";
+
+/**
+ * @brief Header of a texture cache file, the GL enums are the ones glTexStorage2D and glTexSubImage2D take.
+ */
+struct texture_cache_header{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash; // hash_bytes() of the source image file
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    uint32_t internal_format;
+    uint32_t format;
+    uint32_t type;
+};
+
+/**
+ * @brief One mip level of a texture cache file.
+ */
+struct texture_cache_level{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+};
+
+static_assert(sizeof(texture_cache_header) == 40, "texture_cache_header must not change layout");
+static_assert(sizeof(texture_cache_level) == 24, "texture_cache_level must not change layout");
+
+/**
+ * @brief Fills in the level table of a header with a full mip chain and sizes a cache file for it, the pixels are left zeroed.
+ * @param header The header, every field but level_count has to be set.
+ * @param channels The bytes per texel.
+ * @param cache Receives the header, the level table and room for the pixels.
+ * @return The level table.
+ */
+std::vector<texture_cache_level> lay_out_texture_cache(texture_cache_header& header, int channels, std::vector<unsigned char>& cache){
+    header.level_count = 1;
+    while(header.level_count < TEXTURE_CACHE_MAX_LEVELS && ((header.width >> header.level_count) > 0 || (header.height >> header.level_count) > 0)){
+        header.level_count++;
+    }
+    std::vector<texture_cache_level> levels(header.level_count);
+    uint64_t offset = sizeof(texture_cache_header) + header.level_count * sizeof(texture_cache_level);
+    for(uint32_t i = 0; i < header.level_count; i++){
+        levels[i].width = std::max(header.width >> i, 1u);
+        levels[i].height = std::max(header.height >> i, 1u);
+        levels[i].offset = offset;
+        levels[i].size = uint64_t((levels[i].width * channels + 3) & ~3u) * levels[i].height;
+        offset += levels[i].size;
+    }
+    cache.assign(size_t(offset), 0);
+    memcpy(cache.data(), &header, sizeof(header));
+    memcpy(cache.data() + sizeof(header), levels.data(), levels.size() * sizeof(texture_cache_level));
+    return levels;
+}
+
+/**
+ * @brief Fills every level but the first one of a cache file, each level averages 2x2 texels of the previous one.
+ * The last row or column is repeated for odd sizes.
+ * @param cache The cache file, level 0 has to be filled.
+ * @param levels Its level table.
+ * @param channels The bytes per texel.
+ */
+void build_texture_mips(std::vector<unsigned char>& cache, const std::vector<texture_cache_level>& levels, int channels){
+    for(size_t i = 1; i < levels.size(); i++){
+        const texture_cache_level& parent = levels[i - 1];
+        const texture_cache_level& level = levels[i];
+        size_t parent_stride = (parent.width * channels + 3) & ~3u;
+        size_t stride = (level.width * channels + 3) & ~3u;
+        const unsigned char* in = cache.data() + parent.offset;
+        unsigned char* out = cache.data() + level.offset;
+        for(uint32_t y = 0; y < level.height; y++){
+            uint32_t y0 = std::min(y * 2, parent.height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, parent.height - 1);
+            for(uint32_t x = 0; x < level.width; x++){
+                uint32_t x0 = std::min(x * 2, parent.width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, parent.width - 1);
+                for(int c = 0; c < channels; c++){
+                    int sum = in[y0 * parent_stride + x0 * channels + c] + in[y0 * parent_stride + x1 * channels + c]
+                        + in[y1 * parent_stride + x0 * channels + c] + in[y1 * parent_stride + x1 * channels + c];
+                    out[y * stride + x * channels + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Decodes an image and lays it out as a texture cache file with its full mip chain.
+ * RGB images are expanded to RGBA8, the format GPUs store them in anyway. Levels are box filtered from the previous one.
+ * @param source The encoded image file (any format stb_image reads).
+ * @param source_hash The hash stored in the header.
+ * @param cache Receives the cache file.
+ * @return False if the image cannot be decoded.
+ */
+bool build_texture_cache(const std::vector<unsigned char>& source, uint64_t source_hash, std::vector<unsigned char>& cache){
+    int width, height, channels;
+    if(!stbi_info_from_memory(source.data(), int(source.size()), &width, &height, &channels)){
+        return false;
+    }
+    int stored_channels = channels == 3 ? 4 : channels;
+    stbi_set_flip_vertically_on_load_thread(true);
+    unsigned char* pixels = stbi_load_from_memory(source.data(), int(source.size()), &width, &height, &channels, stored_channels);
+    if(pixels == nullptr){
+        return false;
+    }
+    const GLenum internal_formats[] = {GL_R8, GL_RG8, GL_RGBA8, GL_RGBA8};
+    const GLenum formats[] = {GL_RED, GL_RG, GL_RGBA, GL_RGBA};
+    texture_cache_header header;
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.source_hash = source_hash;
+    header.width = uint32_t(width);
+    header.height = uint32_t(height);
+    header.internal_format = internal_formats[stored_channels - 1];
+    header.format = formats[stored_channels - 1];
+    header.type = GL_UNSIGNED_BYTE;
+    std::vector<texture_cache_level> levels = lay_out_texture_cache(header, stored_channels, cache);
+
+    // Level 0 is the image itself with padded rows
+    size_t row_size = size_t(width) * stored_channels;
+    size_t row_stride = (row_size + 3) & ~size_t(3);
+    for(int y = 0; y < height; y++){
+        memcpy(cache.data() + levels[0].offset + y * row_stride, pixels + y * row_size, row_size);
+    }
+    stbi_image_free(pixels);
+    build_texture_mips(cache, levels, stored_channels);
+    return true;
+}
+
+/**
+ * @brief A texture in the cache layout, mapped from its cache file or, right after the cache was built, held in memory.
+ */
+class cached_texture{
+public:
+    /**
+     * @brief Loads the texture of an image file through its cache file next to it (path + TEXTURE_CACHE_EXTENSION).
+     * A missing cache, or one built from a different version of the image, is rebuilt and written back.
+     * @param source_path Path to the image file.
+     * @return False if the image cannot be read.
+     */
+    bool load(const std::string& source_path);
+    /**
+     * @brief Drops the pixels, unmapping the cache file.
+     */
+    void release();
+    /**
+     * @brief Resamples the texture to an RGBA8 mip chain of another size, held in memory (e.g. for a texture array layer).
+     * Does nothing if the texture already is RGBA8 of that size.
+     * @param width The new width.
+     * @param height The new height.
+     */
+    void resize(uint32_t width, uint32_t height);
+    const texture_cache_header& header() const{ return *(const texture_cache_header*)bytes; }
+    const texture_cache_level& level(int index) const{ return ((const texture_cache_level*)(bytes + sizeof(texture_cache_header)))[index]; }
+    /**
+     * @brief Returns the whole cache file, the level offsets point into it.
+     */
+    const unsigned char* data() const{ return bytes; }
+    size_t size() const{ return length; }
+    /**
+     * @brief Returns true if the texture came from an existing cache file instead of being decoded.
+     */
+    bool from_cache() const{ return file.is_open(); }
+private:
+    mapped_file file;
+    std::vector<unsigned char> memory;
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+};
+
+/**
+ * @brief Checks that a buffer is a complete cache file of the current version built from the given source.
+ */
+bool valid_texture_cache(const unsigned char* bytes, size_t size, uint64_t source_hash){
+    if(size < sizeof(texture_cache_header)){
+        return false;
+    }
+    const texture_cache_header& header = *(const texture_cache_header*)bytes;
+    if(header.magic != TEXTURE_CACHE_MAGIC || header.version != TEXTURE_CACHE_VERSION || header.source_hash != source_hash
+        || header.level_count == 0 || header.level_count > TEXTURE_CACHE_MAX_LEVELS
+        || size < sizeof(texture_cache_header) + header.level_count * sizeof(texture_cache_level)){
+        return false;
+    }
+    const texture_cache_level* levels = (const texture_cache_level*)(bytes + sizeof(texture_cache_header));
+    for(uint32_t i = 0; i < header.level_count; i++){
+        if(levels[i].offset % 4 != 0 || levels[i].offset > size || levels[i].size > size - levels[i].offset){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Resamples a texture to an RGBA8 cache file of another size with its full mip chain.
+ * Level 0 is filtered bilinearly from the smallest level of the source that is at least as large, so shrinking by a
+ * power of two copies a cached level. One and two channel images are expanded the way GL samples them, (r, g, 0, 1).
+ * @param source The loaded texture.
+ * @param width The new width.
+ * @param height The new height.
+ * @param cache Receives the cache file.
+ */
+void resample_texture_cache(const cached_texture& source, uint32_t width, uint32_t height, std::vector<unsigned char>& cache){
+    const texture_cache_header& source_header = source.header();
+    uint32_t source_index = 0;
+    while(source_index + 1 < source_header.level_count && source.level(source_index + 1).width >= width
+        && source.level(source_index + 1).height >= height){
+        source_index++;
+    }
+    const texture_cache_level& source_level = source.level(source_index);
+    const int source_channels = source_header.format == GL_RED ? 1 : (source_header.format == GL_RG ? 2 : 4);
+    size_t source_stride = (source_level.width * source_channels + 3) & ~3u;
+    const unsigned char* in = source.data() + source_level.offset;
+
+    texture_cache_header header = source_header;
+    header.width = width;
+    header.height = height;
+    header.internal_format = GL_RGBA8;
+    header.format = GL_RGBA;
+    header.type = GL_UNSIGNED_BYTE;
+    std::vector<texture_cache_level> levels = lay_out_texture_cache(header, 4, cache);
+    unsigned char* out = cache.data() + levels[0].offset;
+    // Texel centers are matched, the source is clamped at its edges
+    float scale_x = float(source_level.width) / float(width);
+    float scale_y = float(source_level.height) / float(height);
+    for(uint32_t y = 0; y < height; y++){
+        float source_y = std::min(std::max((float(y) + 0.5f) * scale_y - 0.5f, 0.0f), float(source_level.height - 1));
+        uint32_t y0 = uint32_t(source_y);
+        uint32_t y1 = std::min(y0 + 1, source_level.height - 1);
+        float fy = source_y - float(y0);
+        for(uint32_t x = 0; x < width; x++){
+            float source_x = std::min(std::max((float(x) + 0.5f) * scale_x - 0.5f, 0.0f), float(source_level.width - 1));
+            uint32_t x0 = uint32_t(source_x);
+            uint32_t x1 = std::min(x0 + 1, source_level.width - 1);
+            float fx = source_x - float(x0);
+            const unsigned char default_texel[4] = {0, 0, 0, 255};
+            for(int c = 0; c < 4; c++){
+                if(c >= source_channels){
+                    out[(y * width + x) * 4 + c] = default_texel[c];
+                    continue;
+                }
+                float top = in[y0 * source_stride + x0 * source_channels + c] * (1.0f - fx) + in[y0 * source_stride + x1 * source_channels + c] * fx;
+                float bottom = in[y1 * source_stride + x0 * source_channels + c] * (1.0f - fx) + in[y1 * source_stride + x1 * source_channels + c] * fx;
+                out[(y * width + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+    build_texture_mips(cache, levels, 4);
+}
+
+bool cached_texture::load(const std::string& source_path){
+    release();
+    std::vector<unsigned char> source;
+    if(!read_whole_file(source_path, source)){
+        return false;
+    }
+    uint64_t source_hash = hash_bytes(source.data(), source.size());
+    std::string cache_path = source_path + TEXTURE_CACHE_EXTENSION;
+    if(file.open(cache_path) && valid_texture_cache(file.data(), file.size(), source_hash)){
+        bytes = file.data();
+        length = file.size();
+        return true;
+    }
+    file.close();
+    if(!build_texture_cache(source, source_hash, memory)){
+        return false;
+    }
+    // A read-only resource folder only costs the decode on every launch
+    replace_file(cache_path, memory.data(), memory.size());
+    bytes = memory.data();
+    length = memory.size();
+    return true;
+}
+
+void cached_texture::resize(uint32_t width, uint32_t height){
+    const texture_cache_header& current = header();
+    if(current.width == width && current.height == height && current.internal_format == GL_RGBA8){
+        return;
+    }
+    std::vector<unsigned char> resized;
+    resample_texture_cache(*this, width, height, resized);
+    file.close();
+    memory.swap(resized);
+    bytes = memory.data();
+    length = memory.size();
+}
+
+void cached_texture::release(){
+    file.close();
+    memory.clear();
+    memory.shrink_to_fit();
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gl_state_cache.h"
+#include "gl_buffer_pool.h"
+#include "job_system.h"
+#include "texture_cache.h"
+
+// Bytes copied into pixel buffers per upload chunk, and the chunks copied per frame
+const size_t TEXTURE_UPLOAD_CHUNK = 256 * 1024;
+const int TEXTURE_CHUNKS_PER_FRAME = 4;
+
+/**
+ * @brief Loads textures without blocking the frame. The job pool maps the texture cache file of every image, decoding
+ * the image and writing the cache only when it is missing or stale. update() then copies a fixed number of chunks per
+ * frame into a pixel buffer object per image, taken from buffer_pool(). Once all mip levels of an image are in its
+ * buffer, they are uploaded from there in their final format, so the driver can copy them asynchronously and no mipmaps
+ * are generated at runtime.
+ * The texture name returned by request() is valid at once, it holds a 1x1 placeholder until the image is resident.
+ * Layers of a texture array are streamed the same way, the loading job resamples their image to the size of the array.
+ */
+class texture_loader{
+public:
+    /**
+     * @brief Requests a texture with the wrapping and filtering of the showcase materials.
+     * @param path Path to the image file.
+     * @return The ID of the texture, it shows the placeholder until the image is resident.
+     */
+    GLuint request(const std::string& path);
+    /**
+     * @brief Requests an image to be streamed into a layer of a texture array, resampled to the size of the array.
+     * The layer keeps its previous contents until the image is resident.
+     * @param path Path to the image file.
+     * @param array The ID of the GL_TEXTURE_2D_ARRAY, every mip level of the array has to be allocated.
+     * @param layer The layer to fill.
+     * @param width The width of the array.
+     * @param height The height of the array.
+     */
+    void request_layer(const std::string& path, GLuint array, int layer, int width, int height);
+    /**
+     * @brief Streams the decoded images to their textures, called once per frame on the GL thread.
+     * @param chunk_budget The number of TEXTURE_UPLOAD_CHUNK sized copies allowed in this call.
+     */
+    void update(int chunk_budget = TEXTURE_CHUNKS_PER_FRAME);
+    /**
+     * @brief Blocks until every requested texture is resident, for code that needs the final images (e.g. benchmarks).
+     */
+    void finish();
+    /**
+     * @brief Returns the number of requested textures that are not resident yet.
+     */
+    int pending() const;
+    /**
+     * @brief Creates the pixel buffers of the uploads up front, so that streaming images makes no buffer allocations.
+     * @param width The width of the largest image that will be streamed.
+     * @param height Its height.
+     * @param count The number of buffers, one per image that is streamed at the same time.
+     */
+    void prewarm(int width, int height, int count);
+private:
+    // One requested image, from the request to the final upload
+    struct texture_request{
+        std::string path;
+        GLuint texture = 0;
+        int layer = -1; // the layer of a texture array, -1 for a 2D texture
+        uint32_t layer_width = 0;
+        uint32_t layer_height = 0;
+        cached_texture image; // set by the loading job
+        bool loaded = false; // set by the loading job
+        bool decoded = false; // set by the loading job once it is done, even if it failed
+        GLuint pixel_buffer = 0;
+        size_t uploaded = 0;
+    };
+
+    std::vector<std::unique_ptr<texture_request>> requests;
+    std::mutex decode_lock; // guards loaded and decoded of every request
+
+    void add_request(const std::string& path, GLuint texture, int layer, uint32_t layer_width, uint32_t layer_height);
+    bool stream(texture_request& request, int& chunk_budget);
+};
+
+GLuint texture_loader::request(const std::string& path){
+    const unsigned char placeholder[4] = {128, 128, 128, 255};
+    GLuint texture;
+    glGenTextures(1, &texture);
+    gl_state().bind_texture(0, GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+    add_request(path, texture, -1, 0, 0);
+    return texture;
+}
+
+void texture_loader::request_layer(const std::string& path, GLuint array, int layer, int width, int height){
+    add_request(path, array, layer, uint32_t(width), uint32_t(height));
+}
+
+void texture_loader::add_request(const std::string& path, GLuint texture, int layer, uint32_t layer_width, uint32_t layer_height){
+    requests.push_back(std::make_unique<texture_request>());
+    texture_request* new_request = requests.back().get();
+    new_request->path = path;
+    new_request->texture = texture;
+    new_request->layer = layer;
+    new_request->layer_width = layer_width;
+    new_request->layer_height = layer_height;
+    job_pool().async([this, new_request](){
+        // The GL thread does not look at the image before decoded is set
+        bool loaded = new_request->image.load(new_request->path);
+        if(loaded && new_request->layer >= 0){
+            new_request->image.resize(new_request->layer_width, new_request->layer_height);
+        }
+        std::lock_guard<std::mutex> guard(decode_lock);
+        new_request->loaded = loaded;
+        new_request->decoded = true;
+    });
+}
+
+bool texture_loader::stream(texture_request& request, int& chunk_budget){
+    {
+        std::lock_guard<std::mutex> guard(decode_lock);
+        if(!request.decoded){
+            return false;
+        }
+    }
+    if(!request.loaded){
+        std::cout << "Could not read the image " << request.path << "!!!" << std::endl;
+        return true;
+    }
+    // The buffer holds every level, from the start of the first one to the end of the file
+    const cached_texture& image = request.image;
+    const texture_cache_header& header = image.header();
+    size_t base = size_t(image.level(0).offset);
+    size_t size = image.size() - base;
+    const unsigned char* pixels = image.data() + base;
+    if(request.pixel_buffer == 0){
+        request.pixel_buffer = buffer_pool().acquire(GL_PIXEL_UNPACK_BUFFER, size);
+    }else{
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, request.pixel_buffer);
+    }
+    while(request.uploaded < size && chunk_budget > 0){
+        size_t chunk = std::min(TEXTURE_UPLOAD_CHUNK, size - request.uploaded);
+        // The buffer is not read by GL before the last chunk is in, so the writes need no synchronization
+        void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, GLintptr(request.uploaded), GLsizeiptr(chunk),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if(destination == nullptr){
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, GLintptr(request.uploaded), GLsizeiptr(chunk), pixels + request.uploaded);
+        }else{
+            memcpy(destination, pixels + request.uploaded, chunk);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        request.uploaded += chunk;
+        chunk_budget--;
+    }
+    bool complete = request.uploaded == size;
+    if(complete && request.layer >= 0){
+        // The array storage already exists, the levels of the layer are replaced in place
+        gl_state().bind_texture(0, GL_TEXTURE_2D_ARRAY, request.texture);
+        for(uint32_t i = 0; i < header.level_count; i++){
+            const texture_cache_level& level = image.level(i);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, GLint(i), 0, 0, request.layer, GLsizei(level.width), GLsizei(level.height), 1,
+                header.format, header.type, (const void*)(uintptr_t)(level.offset - base));
+        }
+    }else if(complete){
+        gl_state().bind_texture(0, GL_TEXTURE_2D, request.texture);
+        // Every level is specified with its final sized format, its rows are padded to the default unpack alignment of 4.
+        // Immutable storage (glTexStorage2D) would need a texture that was never sampled: the name already held the
+        // placeholder, and llvmpipe keeps sampling that after the swap.
+        for(uint32_t i = 0; i < header.level_count; i++){
+            const texture_cache_level& level = image.level(i);
+            glTexImage2D(GL_TEXTURE_2D, GLint(i), GLint(header.internal_format), GLsizei(level.width), GLsizei(level.height), 0,
+                header.format, header.type, (const void*)(uintptr_t)(level.offset - base));
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(header.level_count) - 1);
+    }
+    if(complete){
+        // The pool only hands the buffer out again once the upload that reads it is done
+        buffer_pool().release(request.pixel_buffer);
+        request.pixel_buffer = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return complete;
+}
+
+void texture_loader::update(int chunk_budget){
+    for(size_t i = 0; i < requests.size() && chunk_budget > 0;){
+        if(stream(*requests[i], chunk_budget)){
+            requests.erase(requests.begin() + i);
+        }else{
+            i++;
+        }
+    }
+}
+
+void texture_loader::finish(){
+    while(!requests.empty()){
+        update(1 << 30);
+        if(!requests.empty()){
+            std::this_thread::yield();
+        }
+    }
+}
+
+int texture_loader::pending() const{
+    return int(requests.size());
+}
+
+void texture_loader::prewarm(int width, int height, int count){
+    // Every level of an RGBA image, the largest format the texture cache stores
+    size_t size = 0;
+    for(int level_width = width, level_height = height; ; level_width = std::max(1, level_width / 2), level_height = std::max(1, level_height / 2)){
+        size += size_t(level_width) * size_t(level_height) * 4;
+        if(level_width == 1 && level_height == 1){
+            break;
+        }
+    }
+    buffer_pool().prewarm(GL_PIXEL_UNPACK_BUFFER, size, count);
+}
+
+/**
+ * @brief Returns the texture loader shared by the whole application.
+ */
+texture_loader& texture_library(){
+    static texture_loader loader;
+    return loader;
+}
+
+#endif
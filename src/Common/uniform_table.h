@@ -0,0 +1,270 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Counts glUniform* calls issued and skipped by every uniform table, reset by the caller when needed.
+ */
+struct uniform_stats{
+    long long uploads = 0;
+    long long skipped = 0;
+};
+
+static uniform_stats uniform_upload_stats;
+
+/**
+ * @brief Per-program table of uniform locations built once by reflection after link.
+ * Every uniform gets a slot that remembers the last uploaded value, so setting an unchanged
+ * value does not reach the driver. Setters upload to the currently bound program, exactly like glUniform*.
+ * Values written with glUniform* directly bypass the table and leave its cached values stale.
+ */
+class uniform_table{
+public:
+    /**
+     * @brief Reflects all active uniforms of a linked program.
+     * @param program The linked shader program ID.
+     */
+    void build(GLuint program);
+    /**
+     * @brief Adds one uniform to the table, build() calls it for every reflected uniform.
+     * @param name The full uniform name (e.g. "point_sources[2].linear").
+     * @param location The uniform location.
+     * @param type The GL type of the uniform.
+     * @return The slot of the new uniform.
+     */
+    int add_uniform(const std::string& name, GLint location, GLenum type);
+    /**
+     * @brief Returns the slot of a uniform by its full name (e.g. "view" or "point_sources[2].linear").
+     * @param name The uniform name.
+     * @return The slot index, or -1 if the program has no such active uniform.
+     */
+    int slot(std::string_view name) const;
+    /**
+     * @brief Returns the slot of one element of a uniform array (e.g. "point_sources", 2, "linear").
+     * @param array The array name without brackets.
+     * @param index The array element.
+     * @param member The struct member, empty for arrays of plain types.
+     * @return The slot index, or -1 if the element is not active.
+     */
+    int slot(std::string_view array, int index, std::string_view member = "") const;
+    /**
+     * @brief Returns the slots of one member across all elements of a uniform array, indexed by element.
+     * @param array The array name without brackets.
+     * @param member The struct member, empty for arrays of plain types.
+     * @return The slots per element, empty if the array is not active.
+     */
+    const std::vector<int>& array_slots(std::string_view array, std::string_view member = "") const;
+    /**
+     * @brief Returns one element of an array_slots() column.
+     * @param column The slots per element.
+     * @param index The array element.
+     * @return The slot, or -1 if the element is out of range.
+     */
+    static int element(const std::vector<int>& column, int index){
+        return (index >= 0 && index < int(column.size())) ? column[index] : -1;
+    }
+
+    void set_1i(int slot, int value);
+    void set_1f(int slot, float value);
+    void set_2f(int slot, const glm::vec2& value);
+    void set_3f(int slot, float value1, float value2, float value3);
+    void set_3f(int slot, const glm::vec3& value);
+    void set_M3fv(int slot, const glm::mat3& value);
+    void set_M4fv(int slot, const glm::mat4& value);
+
+    void set_1i(std::string_view name, int value){ set_1i(slot(name), value); }
+    void set_1f(std::string_view name, float value){ set_1f(slot(name), value); }
+    void set_2f(std::string_view name, const glm::vec2& value){ set_2f(slot(name), value); }
+    void set_3f(std::string_view name, float value1, float value2, float value3){ set_3f(slot(name), value1, value2, value3); }
+    void set_3f(std::string_view name, const glm::vec3& value){ set_3f(slot(name), value); }
+    void set_M3fv(std::string_view name, const glm::mat3& value){ set_M3fv(slot(name), value); }
+    void set_M4fv(std::string_view name, const glm::mat4& value){ set_M4fv(slot(name), value); }
+private:
+    struct uniform_slot{
+        GLint location;
+        GLenum type;
+        bool valid;
+        float value[16];
+    };
+    /**
+     * @brief Compares the new value with the cached one and stores it.
+     * @return True if the value changed and has to be uploaded.
+     */
+    bool update(int slot, const void* value, size_t size);
+    int add_slot(GLint location, GLenum type);
+    void add_array_element(const std::string& name, int slot);
+
+    std::vector<uniform_slot> slots;
+    std::map<std::string, int, std::less<>> by_name;
+    // array name -> member name -> slot per element
+    std::map<std::string, std::map<std::string, std::vector<int>, std::less<>>, std::less<>> arrays;
+};
+
+void uniform_table::build(GLuint program){
+    slots.clear();
+    by_name.clear();
+    arrays.clear();
+
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<char> buffer(max_length + 1);
+    for(GLint i = 0; i < count; i++){
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, GLuint(i), GLsizei(buffer.size()), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+        if(location < 0){
+            continue; // uniform block members have no location
+        }
+        if(size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0){
+            // Arrays of plain types are reported once as "name[0]", resolve every element here
+            std::string base = name.substr(0, name.size() - 3);
+            for(GLint element = 0; element < size; element++){
+                std::string element_name = base + "[" + std::to_string(element) + "]";
+                GLint element_location = glGetUniformLocation(program, element_name.c_str());
+                if(element_location < 0){
+                    continue;
+                }
+                int new_slot = add_uniform(element_name, element_location, type);
+                if(element == 0){
+                    by_name[base] = new_slot;
+                }
+            }
+            continue;
+        }
+        add_uniform(name, location, type);
+    }
+}
+
+int uniform_table::add_uniform(const std::string& name, GLint location, GLenum type){
+    int new_slot = add_slot(location, type);
+    by_name[name] = new_slot;
+    add_array_element(name, new_slot);
+    return new_slot;
+}
+
+int uniform_table::add_slot(GLint location, GLenum type){
+    uniform_slot new_slot;
+    new_slot.location = location;
+    new_slot.type = type;
+    new_slot.valid = false;
+    std::memset(new_slot.value, 0, sizeof(new_slot.value));
+    slots.push_back(new_slot);
+    return int(slots.size()) - 1;
+}
+
+void uniform_table::add_array_element(const std::string& name, int slot){
+    size_t open = name.find('[');
+    if(open == std::string::npos){
+        return;
+    }
+    size_t close = name.find(']', open);
+    if(close == std::string::npos){
+        return;
+    }
+    int index = std::stoi(name.substr(open + 1, close - open - 1));
+    std::string array = name.substr(0, open);
+    // "point_sources[2].linear" -> member "linear", "lightSourcePosition[2]" -> member ""
+    std::string member = (close + 2 <= name.size()) ? name.substr(close + 2) : "";
+    std::vector<int>& column = arrays[array][member];
+    if(int(column.size()) <= index){
+        column.resize(index + 1, -1);
+    }
+    column[index] = slot;
+}
+
+int uniform_table::slot(std::string_view name) const{
+    auto found = by_name.find(name);
+    return (found == by_name.end()) ? -1 : found->second;
+}
+
+int uniform_table::slot(std::string_view array, int index, std::string_view member) const{
+    const std::vector<int>& column = array_slots(array, member);
+    if(index < 0 || index >= int(column.size())){
+        return -1;
+    }
+    return column[index];
+}
+
+const std::vector<int>& uniform_table::array_slots(std::string_view array, std::string_view member) const{
+    static const std::vector<int> empty;
+    auto found_array = arrays.find(array);
+    if(found_array == arrays.end()){
+        return empty;
+    }
+    auto found_member = found_array->second.find(member);
+    if(found_member == found_array->second.end()){
+        return empty;
+    }
+    return found_member->second;
+}
+
+bool uniform_table::update(int slot, const void* value, size_t size){
+    if(slot < 0){
+        return false;
+    }
+    uniform_slot& cached = slots[slot];
+    if(cached.valid && std::memcmp(cached.value, value, size) == 0){
+        uniform_upload_stats.skipped++;
+        return false;
+    }
+    std::memcpy(cached.value, value, size);
+    cached.valid = true;
+    uniform_upload_stats.uploads++;
+    return true;
+}
+
+void uniform_table::set_1i(int slot, int value){
+    if(update(slot, &value, sizeof(value))){
+        glUniform1i(slots[slot].location, value);
+    }
+}
+
+void uniform_table::set_1f(int slot, float value){
+    if(update(slot, &value, sizeof(value))){
+        glUniform1f(slots[slot].location, value);
+    }
+}
+
+void uniform_table::set_2f(int slot, const glm::vec2& value){
+    if(update(slot, &value[0], sizeof(float) * 2)){
+        glUniform2f(slots[slot].location, value.x, value.y);
+    }
+}
+
+void uniform_table::set_3f(int slot, float value1, float value2, float value3){
+    float value[3] = {value1, value2, value3};
+    if(update(slot, value, sizeof(value))){
+        glUniform3f(slots[slot].location, value1, value2, value3);
+    }
+}
+
+void uniform_table::set_3f(int slot, const glm::vec3& value){
+    set_3f(slot, value.x, value.y, value.z);
+}
+
+void uniform_table::set_M3fv(int slot, const glm::mat3& value){
+    if(update(slot, &value[0][0], sizeof(float) * 9)){
+        glUniformMatrix3fv(slots[slot].location, 1, GL_FALSE, &value[0][0]);
+    }
+}
+
+void uniform_table::set_M4fv(int slot, const glm::mat4& value){
+    if(update(slot, &value[0][0], sizeof(float) * 16)){
+        glUniformMatrix4fv(slots[slot].location, 1, GL_FALSE, &value[0][0]);
+    }
+}
+
+#endif
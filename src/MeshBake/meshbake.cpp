@@ -0,0 +1,185 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "mesh_generator.h"
+#include "mesh_bake.h"
+#include "mesh_file.h"
+
+/**
+ * @brief What to bake and how.
+ */
+struct bake_options{
+    std::string input;
+    std::string output;
+    int cache_size = 32;
+    bool weld = true;
+};
+
+/**
+ * @brief Parses the command line, wrong arguments end the program with the usage.
+ */
+bake_options parse_bake_options(int argc, char** argv){
+    bake_options options;
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if(argument == "--cache-size" && has_value && (options.cache_size = atoi(argv[i + 1])) > 0){
+            i++;
+        }else if(argument == "--no-weld"){
+            options.weld = false;
+        }else if(argument.compare(0, 2, "--") != 0){
+            files.push_back(argument);
+        }else{
+            files.clear();
+            break;
+        }
+    }
+    if(files.size() != 2){
+        std::cout << "Usage: " << argv[0] << " <input.obj | cube | plane | sphere> <output" << MESH_FILE_EXTENSION << ">"
+            " [--cache-size N] [--no-weld]\n";
+        exit(1);
+    }
+    options.input = files[0];
+    options.output = files[1];
+    return options;
+}
+
+/**
+ * @brief Resolves a 1-based or negative (relative) OBJ index.
+ * @param index The index as written in the file.
+ * @param count The number of elements read so far.
+ * @return The 0-based index, or -1 if it is missing or out of range.
+ */
+int obj_index(int index, size_t count){
+    int resolved = index > 0 ? index - 1 : int(count) + index;
+    return (index != 0 && resolved >= 0 && resolved < int(count)) ? resolved : -1;
+}
+
+/**
+ * @brief Reads the triangles of a Wavefront OBJ file: positions, texture coordinates and normals. Polygons are split
+ * into fans, corners without a normal get the normal of their face and corners without texture coordinates get (0, 0).
+ * Every corner becomes its own vertex, weld_vertices() merges them afterwards. Each object ("o") and group ("g") with
+ * triangles becomes its own part, so that it can be loaded on its own.
+ * @param path The file path.
+ * @param parts Receives the parts, with zero tangents.
+ * @return False if the file cannot be read or has no triangles.
+ */
+bool load_obj(const std::string& path, std::vector<mesh_data>& parts){
+    std::ifstream file(path);
+    if(!file.is_open()){
+        return false;
+    }
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    parts.assign(1, mesh_data());
+    std::string line;
+    while(std::getline(file, line)){
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        if((type == "o" || type == "g") && !parts.back().indices.empty()){
+            parts.emplace_back();
+        }else if(type == "v"){
+            glm::vec3 position(0.0f);
+            stream >> position.x >> position.y >> position.z;
+            positions.push_back(position);
+        }else if(type == "vt"){
+            glm::vec2 uv(0.0f);
+            stream >> uv.x >> uv.y;
+            uvs.push_back(uv);
+        }else if(type == "vn"){
+            glm::vec3 normal(0.0f);
+            stream >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        }else if(type == "f"){
+            // Each corner is "v", "v/vt", "v//vn" or "v/vt/vn"
+            struct corner{ int position; int uv; int normal; };
+            std::vector<corner> corners;
+            std::string token;
+            while(stream >> token){
+                int v = 0, vt = 0, vn = 0;
+                if(sscanf(token.c_str(), "%d/%d/%d", &v, &vt, &vn) != 3 && sscanf(token.c_str(), "%d//%d", &v, &vn) != 2){
+                    vn = 0;
+                    if(sscanf(token.c_str(), "%d/%d", &v, &vt) != 2){
+                        vt = 0;
+                        sscanf(token.c_str(), "%d", &v);
+                    }
+                }
+                corner c = {obj_index(v, positions.size()), obj_index(vt, uvs.size()), obj_index(vn, normals.size())};
+                if(c.position < 0){
+                    corners.clear();
+                    break;
+                }
+                corners.push_back(c);
+            }
+            mesh_data& mesh = parts.back();
+            for(size_t i = 2; i < corners.size(); i++){
+                const corner triangle[3] = {corners[0], corners[i - 1], corners[i]};
+                glm::vec3 face_normal = glm::cross(positions[triangle[1].position] - positions[triangle[0].position],
+                    positions[triangle[2].position] - positions[triangle[0].position]);
+                face_normal = glm::dot(face_normal, face_normal) > 0.0f ? glm::normalize(face_normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+                for(const corner& c : triangle){
+                    glm::vec3 normal = c.normal >= 0 ? normals[c.normal] : face_normal;
+                    glm::vec2 uv = c.uv >= 0 ? uvs[c.uv] : glm::vec2(0.0f);
+                    mesh.indices.push_back(mesh.add_vertex(positions[c.position], normal, uv));
+                }
+            }
+        }
+    }
+    if(parts.back().indices.empty()){
+        parts.pop_back();
+    }
+    return !parts.empty();
+}
+
+int main(int argc, char** argv){
+    bake_options options = parse_bake_options(argc, argv);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<mesh_data> parts(1);
+    if(options.input == "cube"){
+        parts[0] = generate_cube(1.0f);
+    }else if(options.input == "plane"){
+        parts[0] = generate_plane(1.0f, 1.0f, 1);
+    }else if(options.input == "sphere"){
+        parts[0] = generate_sphere(0.5f, 32, 16);
+    }else if(!load_obj(options.input, parts)){
+        std::cout << "Could not read the triangles of " << options.input << "!!!" << std::endl;
+        return 1;
+    }
+    size_t triangles = 0, input_vertices = 0, output_vertices = 0;
+    double input_misses = 0.0, output_misses = 0.0;
+    // Every part is baked on its own, the file stores it as a submesh that is uploaded and drawn on its own
+    for(mesh_data& mesh : parts){
+        triangles += mesh.indices.size() / 3;
+        input_vertices += mesh.vertex_count();
+        input_misses += average_cache_miss_ratio(mesh.indices, mesh.vertex_count(), options.cache_size) * (mesh.indices.size() / 3);
+        if(options.weld){
+            weld_vertices(mesh);
+        }
+        generate_tangents_parallel(mesh);
+        optimize_vertex_cache(mesh, options.cache_size);
+        optimize_vertex_fetch(mesh);
+        output_vertices += mesh.vertex_count();
+        output_misses += average_cache_miss_ratio(mesh.indices, mesh.vertex_count(), options.cache_size) * (mesh.indices.size() / 3);
+    }
+
+    if(!save_mesh_file(options.output, parts)){
+        std::cout << "Could not write " << options.output << "!!!" << std::endl;
+        return 1;
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %zu submeshes, %zu triangles, %zu -> %zu vertices, ACMR %.3f -> %.3f (cache of %d), %.1f ms on %d threads\n",
+        options.output.c_str(), parts.size(), triangles, input_vertices, output_vertices, input_misses / triangles,
+        output_misses / triangles, options.cache_size, elapsed, job_pool().thread_count());
+    return 0;
+}
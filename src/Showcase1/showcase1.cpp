@@ -4,6 +4,7 @@
 #include <math.h>
 #include <fstream>
 #include <sstream>
+#include "headless.h"
 
 const int OPENGL_TARGET_MAJOR = 3;
 const int OPENGL_TARGET_MINOR = 3;
@@ -92,9 +93,10 @@ GLuint create_triangle_VAO(float* vertices, int size);
  */
 GLuint create_triangle_VAO_OG(float* vertices, int size, float* colors, int color_size);
 
-int main(){
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
     double t;
-    GLFWwindow* window = initiate();
+    GLFWwindow* window = options.headless ? initiate_headless(WINDOW_NAME, options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_CORE_PROFILE) : initiate();
     GLuint program;
     if(alternative_fragments){
         program = create_shader_program("./res/vertex_shader1.glsl", "./res/fragment_shader1.glsl");
@@ -111,7 +113,8 @@ int main(){
         triangle2_VAO = create_triangle_VAO_OG(vertices2, sizeof(vertices2), default_colors2_og, sizeof(default_colors2_og));
     }
 
-    while(!glfwWindowShouldClose(window)){
+    run_timer timer(options);
+    while(timer.keep_running(window)){
         glfwPollEvents();
         process_input(window);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -142,7 +145,11 @@ int main(){
         }
         glDrawArrays(GL_TRIANGLES, 0, 3);
 
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report(WINDOW_NAME);
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "functions.h"
+#include "headless.h"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
@@ -63,9 +64,10 @@ bool wireframe_mode = false;
 bool caps_flag = false;
 bool w_flag = false;
 
-int main(){
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
     //Program Setup
-    GLFWwindow* window = initiate("Showcase 21");
+    GLFWwindow* window = options.headless ? initiate_headless("Showcase 21", options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_COMPAT_PROFILE) : initiate("Showcase 21");
     GLuint polygon_program = create_shader_program("./res/VertexShader_11.txt", "./res/FragmentShader_11.txt");
 
     GLuint polygon6_VAO = create_VAO(polygon6_vertices, sizeof(polygon6_vertices));
@@ -84,7 +86,8 @@ int main(){
 	ImGui_ImplGlfw_InitForOpenGL(window, true);
 	ImGui_ImplOpenGL3_Init(glsl_version);
 
-    while(!glfwWindowShouldClose(window)){
+    run_timer timer(options);
+    while(timer.keep_running(window)){
         //Frame setup
         glfwPollEvents();
         process_input(window);
@@ -126,7 +129,11 @@ int main(){
             glBindVertexArray(polygon6_VAO);
             glDrawArrays(GL_POLYGON, 0, 6);
         }
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report("Showcase 21");
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
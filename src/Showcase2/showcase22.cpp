@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "functions.h"
+#include "headless.h"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
@@ -37,9 +38,11 @@ bool wireframe_mode = false;
 bool caps_flag = false;
 bool tab_flag = false;
 
-int main(){
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
     //Program Setup
-    GLFWwindow* window = initiate("Showcase 22 (Press CAPS LOCK to change polygon and TAB for wireframe!)");
+    const std::string window_name = "Showcase 22 (Press CAPS LOCK to change polygon and TAB for wireframe!)";
+    GLFWwindow* window = options.headless ? initiate_headless(window_name, options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_COMPAT_PROFILE) : initiate(window_name);
     GLuint polygon_program = create_shader_program("./res/VertexShader_12.txt", "./res/FragmentShader_12.txt");
     GLuint polygon6_VAO = create_VAO(polygon6_vertices, sizeof(polygon6_vertices));
     GLuint polygon10_VAO = create_VAO(polygon10_vertices, sizeof(polygon10_vertices));
@@ -49,7 +52,8 @@ int main(){
     float frame_time = 0.0f;
     float current_frame = 0.0f;
     float last_frame = 0.0f;
-    while(!glfwWindowShouldClose(window)){
+    run_timer timer(options);
+    while(timer.keep_running(window)){
         //Log frames to implement frame-based moving
         current_frame = float(glfwGetTime());
         frame_time = current_frame - last_frame;
@@ -71,7 +75,11 @@ int main(){
             glDrawArrays(GL_POLYGON, 0, 6);
         }
         
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report(window_name);
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
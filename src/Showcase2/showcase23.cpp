@@ -10,6 +10,7 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include "functions.h"
+#include "headless.h"
 
 void process_input(GLFWwindow* window);
 
@@ -65,9 +66,10 @@ glm::vec3 cube_positions[] = {
 };
 
 
-int main(){
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
     //Program Setup
-    GLFWwindow* window = initiate("Showcase 23");
+    GLFWwindow* window = options.headless ? initiate_headless("Showcase 23", options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_COMPAT_PROFILE) : initiate("Showcase 23");
     GLuint program = create_shader_program("./res/VertexShader_13.txt", "./res/FragmentShader_13.txt");
     GLuint cube_VAO = create_color_VAO(vertices, sizeof(vertices));
     glm::mat4 identity = glm::mat4(1.0f);
@@ -93,7 +95,8 @@ int main(){
     float frame_time = 0.0f;
     float current_frame = 0.0f;
     float last_frame = 0.0f;
-    while(!glfwWindowShouldClose(window)){
+    run_timer timer(options);
+    while(timer.keep_running(window)){
         //Log frames to implement frame-based moving
         current_frame = float(glfwGetTime());
         frame_time = current_frame - last_frame;
@@ -130,7 +133,7 @@ int main(){
         int model_location = glGetUniformLocation(program, "model");
         int view_location = glGetUniformLocation(program, "view");
         int projection_location = glGetUniformLocation(program, "projection");
-        glm::mat4 projection = glm::perspective(glm::radians(70.0f), WINDOW_X / (float)WINDOW_Y, 0.3f, 100.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(70.0f), (float)options.width / (float)options.height, 0.3f, 100.0f);
         glm::mat4 view = glm::translate(identity, glm::vec3(0.0f, 0.0f, -8.0f));
         glUniformMatrix4fv(view_location, 1, GL_FALSE, &view[0][0]);
         glUniformMatrix4fv(projection_location, 1, GL_FALSE, &projection[0][0]);
@@ -178,7 +181,11 @@ int main(){
         cube3 = glm::scale(cube3, glm::vec3(1 / 1.9f, 1 / 1.9f, 1 / 1.9f));
         glUniformMatrix4fv(model_location, 1, GL_FALSE, &cube3[0][0]);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report("Showcase 23");
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
@@ -10,7 +10,12 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include "functions.h"
+#include "headless.h"
 #include "Camera.h"
+#include "uniform_table.h"
+#include "mesh_registry.h"
+#include "frame_profiler.h"
+#include "profiler_panel.h"
 
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 bool cursor_enabled = false;
@@ -37,53 +42,6 @@ void process_mouse_input(GLFWwindow* window, double givenMousePositionX, double
  */
 void process_scroll_input(GLFWwindow* givenWindow, double givenScrollOffsetX, double givenScrollOffsetY);
 
-GLfloat vertices[] =
-{
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-
-
-        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
-
-};
-
 glm::vec3 cube_positions[] =
 {
     glm::vec3(0.0f,  0.0f,  0.0f),
@@ -165,12 +123,26 @@ float quadratic_values[] = {0.2f, 0.07f, 0.032f, 0.017f, 0.0075f};
 bool light_flags[] = {true, true, true, true, true, true};
 bool global_point_light_flag = true;
 bool global_direct_light_flag = true;
-int main(){
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
     //Program Setup
-    GLFWwindow* window = initiate("Showcase 24");
-    GLuint cube_VAO = create_color_VAO(vertices, sizeof(vertices));
+    GLFWwindow* window = options.headless ? initiate_headless("Showcase 24", options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_COMPAT_PROFILE) : initiate("Showcase 24");
+    const gpu_mesh& cube_mesh = mesh_library().cube();
     GLuint cube_program = create_shader_program("./res/VertexShader_21.txt", "./res/FragmentShader_21.txt");
     GLuint light_program = create_shader_program("./res/Vertex_light_21.txt", "./res/Fragment_light_21.txt");
+    //Uniform locations are resolved once here instead of on every upload
+    uniform_table cube_uniforms;
+    cube_uniforms.build(cube_program);
+    uniform_table light_uniforms;
+    light_uniforms.build(light_program);
+    const std::vector<int>& light_position_slots = cube_uniforms.array_slots("light_sources", "position");
+    const std::vector<int>& light_type_slots = cube_uniforms.array_slots("light_sources", "type");
+    const std::vector<int>& light_direction_slots = cube_uniforms.array_slots("light_sources", "direction");
+    const std::vector<int>& light_ambient_slots = cube_uniforms.array_slots("light_sources", "ambient_color");
+    const std::vector<int>& light_specular_slots = cube_uniforms.array_slots("light_sources", "specular_color");
+    const std::vector<int>& light_constant_slots = cube_uniforms.array_slots("light_sources", "constant");
+    const std::vector<int>& light_linear_slots = cube_uniforms.array_slots("light_sources", "linear");
+    const std::vector<int>& light_quadratic_slots = cube_uniforms.array_slots("light_sources", "quadratic");
     glm::mat4 identity = glm::mat4(1.0f);
     glm::vec3 light_source_color(1.0f, 1.0f, 1.0f);
     glEnable(GL_DEPTH_TEST);
@@ -193,7 +165,12 @@ int main(){
     float current_frame = 0.0f;
     float last_frame = 0.0f;
     float moving_light_degrees = 0.0f;
-    while(!glfwWindowShouldClose(window)){
+    int pass_cubes = profiler().add_pass("Lit cubes");
+    int pass_lights = profiler().add_pass("Light sources");
+    int pass_imgui = profiler().add_pass("ImGui");
+    run_timer timer(options);
+    while(timer.keep_running(window)){
+        profiler().begin_frame();
         //Log frames to implement frame-based moving
         current_frame = float(glfwGetTime());
         frame_time = current_frame - last_frame;
@@ -203,6 +180,7 @@ int main(){
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
         process_keyboard_input(window, frame_time);
         // ImGUI Window Render
+        profiler().begin(pass_imgui);
         ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
@@ -231,121 +209,93 @@ int main(){
         }
         ImGui::Text("FPS: %.2f, Frametime: %.3f", 1.0 / frame_time, frame_time);
 		ImGui::End();
+        draw_profiler_window(profiler());
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         //Program here
+        profiler().begin(pass_cubes);
         glUseProgram(cube_program);
-        glBindVertexArray(cube_VAO);
+        glBindVertexArray(cube_mesh.VAO);
         //Set the position of the moving light;
         moving_light_degrees = moving_light_degrees + frame_time * moving_light_speed;
         light_positions[5] = glm::vec3(moving_light_radius * cos(moving_light_degrees), moving_light_radius * sin(moving_light_degrees), 0);
         //View position
-        GLuint camera_position = glGetUniformLocation(cube_program, "camera_position");
-        glUniform3f(camera_position, camera.Position.x, camera.Position.y, camera.Position.z);
+        cube_uniforms.set_3f("camera_position", camera.Position);
         glm::mat4 view = camera.GetViewMatrix();
-        GLuint view_location = glGetUniformLocation(cube_program, "view");
-        glUniformMatrix4fv(view_location, 1, GL_FALSE, &view[0][0]);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WINDOW_X / (float)WINDOW_Y, 0.3f, 100.0f);
-        GLuint projection_location = glGetUniformLocation(cube_program, "projection");
-        glUniformMatrix4fv(projection_location, 1, GL_FALSE, &projection[0][0]);
+        cube_uniforms.set_M4fv("view", view);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)options.width / (float)options.height, 0.3f, 100.0f);
+        cube_uniforms.set_M4fv("projection", projection);
         for(int i = 0; i < 10; i++){
             //Material Positions
-            GLuint ambient_color = glGetUniformLocation(cube_program, "material.ambient_color");
-            glUniform3f(ambient_color, ambient_colors[i].x, ambient_colors[i].y, ambient_colors[i].z);
-            GLuint diffuse_color = glGetUniformLocation(cube_program, "material.diffuse_color");
-            glUniform3f(diffuse_color, diffuse_colors[i].x, diffuse_colors[i].y, diffuse_colors[i].z);
-            GLuint specular_color = glGetUniformLocation(cube_program, "material.specular_color");
-            glUniform3f(specular_color, specular_colors[i].x, specular_colors[i].y, specular_colors[i].z);
-            GLuint shininess = glGetUniformLocation(cube_program, "material.shininess");
-            glUniform1f(shininess, cube_shininess[i]);
+            cube_uniforms.set_3f("material.ambient_color", ambient_colors[i]);
+            cube_uniforms.set_3f("material.diffuse_color", diffuse_colors[i]);
+            cube_uniforms.set_3f("material.specular_color", specular_colors[i]);
+            cube_uniforms.set_1f("material.shininess", cube_shininess[i]);
             for(int i = 0; i < 6; i++){
                 //Light positions
-                std::string light_position_name = "light_sources[" + std::to_string(i) + "].position";
-                GLuint light_position = glGetUniformLocation(cube_program, light_position_name.c_str());
-                glUniform3f(light_position, light_positions[i].x, light_positions[i].y, light_positions[i].z);
+                cube_uniforms.set_3f(uniform_table::element(light_position_slots, i), light_positions[i]);
 
-                std::string source_type_name = "light_sources[" + std::to_string(i) + "].type";
-                std::string source_direction_name = "light_sources[" + std::to_string(i) + "].direction";
-                GLuint light_type = glGetUniformLocation(cube_program, source_type_name.c_str());
-                GLuint light_direction = glGetUniformLocation(cube_program, source_direction_name.c_str());                
+                int light_type = 0;
                 if(i > 1 && i != 5){
-                    glUniform1i(light_type, 1);
-                    glUniform3f(light_direction, light_directions[i - 2].x, light_directions[i - 2].y, light_directions[i - 2].z);
-                }else{
-                    glUniform1i(light_type, 0);
+                    light_type = 1;
+                    cube_uniforms.set_3f(uniform_table::element(light_direction_slots, i), light_directions[i - 2]);
                 }
 
                 if(light_flags[i] == false){
-                    glUniform1i(light_type, 2);
+                    light_type = 2;
                 }
 
                 if(global_point_light_flag == false && (i < 2 || i == 5)){
-                    glUniform1i(light_type, 2);
+                    light_type = 2;
                 }
 
                 if(global_direct_light_flag == false && i > 1 && i != 5){
-                    glUniform1i(light_type, 2);
+                    light_type = 2;
                 }
+                cube_uniforms.set_1i(uniform_table::element(light_type_slots, i), light_type);
 
-                std::string source_ambient_name = "light_sources[" + std::to_string(i) + "].ambient_color";
-                GLuint ambient_light = glGetUniformLocation(cube_program, source_ambient_name.c_str());
-                glUniform3f(ambient_light, 1.0f, 1.0f, 1.0f);
-
-                std::string source_diffuse_name = "light_sources[" + std::to_string(i) + "].diffuse_color";
-                GLuint diffuse_light = glGetUniformLocation(cube_program, source_diffuse_name.c_str());
-                glUniform3f(ambient_light, 1.0f, 1.0f, 1.0f);
-
-                std::string source_specular_color = "light_sources[" + std::to_string(i) + "].specular_color";
-                GLuint specular_light = glGetUniformLocation(cube_program, source_specular_color.c_str());
-                glUniform3f(specular_light, 1.0f, 1.0f, 1.0f);
-
-                std::string source_constant = "light_sources[" + std::to_string(i) + "].constant";
-                GLuint light_constant = glGetUniformLocation(cube_program, source_constant.c_str());
-                glUniform1f(light_constant, 1.0f);
-
-                std::string source_linear = "light_sources[" + std::to_string(i) + "].linear";
-                GLuint light_linear = glGetUniformLocation(cube_program, source_linear.c_str());
-                glUniform1f(light_linear, linear_values[ki_option]);
-                std::string source_quadratic = "light_sources[" + std::to_string(i) + "].quadratic";
-                GLuint light_quadratic = glGetUniformLocation(cube_program, source_quadratic.c_str());
-                glUniform1f(light_quadratic, quadratic_values[ki_option]);
+                cube_uniforms.set_3f(uniform_table::element(light_ambient_slots, i), 1.0f, 1.0f, 1.0f);
+                cube_uniforms.set_3f(uniform_table::element(light_specular_slots, i), 1.0f, 1.0f, 1.0f);
+                cube_uniforms.set_1f(uniform_table::element(light_constant_slots, i), 1.0f);
+                cube_uniforms.set_1f(uniform_table::element(light_linear_slots, i), linear_values[ki_option]);
+                cube_uniforms.set_1f(uniform_table::element(light_quadratic_slots, i), quadratic_values[ki_option]);
             }
 
             glm::mat4 model = glm::translate(identity, cube_positions[i]);
             model = glm::rotate(model, glm::radians(20.0f) * i, glm::vec3(1.0f, 0.3f, 0.5f));
             glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(model)));
-            GLuint model_location = glGetUniformLocation(cube_program, "model");
-            GLuint normal_transformation_location = glGetUniformLocation(cube_program, "normal_transformation");
-            glUniformMatrix4fv(model_location, 1, GL_FALSE, &model[0][0]);
-            glUniformMatrix3fv(normal_transformation_location, 1, GL_FALSE, &normal_transformation[0][0]);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            cube_uniforms.set_M4fv("model", model);
+            cube_uniforms.set_M3fv("normal_transformation", normal_transformation);
+            cube_mesh.draw();
         }
         //Now for the lights
+        profiler().begin(pass_lights);
         glUseProgram(light_program);
-        view_location = glGetUniformLocation(light_program, "view");
-        glUniformMatrix4fv(view_location, 1, GL_FALSE, &view[0][0]);
-        projection_location = glGetUniformLocation(light_program, "projection");
-        glUniformMatrix4fv(projection_location, 1, GL_FALSE, &projection[0][0]);
+        light_uniforms.set_M4fv("view", view);
+        light_uniforms.set_M4fv("projection", projection);
         for(int i = 0; i < 6; i++){
-            GLuint active_light_location = glGetUniformLocation(light_program, "active_light");
             if(light_flags[i] == true){
                 if(global_direct_light_flag == true && i > 1 && i != 5){
-                    glUniform1i(active_light_location, 1);
+                    light_uniforms.set_1i("active_light", 1);
                 }else if(global_point_light_flag == true && (i < 2 || i == 5)){
-                    glUniform1i(active_light_location, 1);
+                    light_uniforms.set_1i("active_light", 1);
                 }else{
-                    glUniform1i(active_light_location, 0);
+                    light_uniforms.set_1i("active_light", 0);
                 }
             }else{
-                glUniform1i(active_light_location, 0);
+                light_uniforms.set_1i("active_light", 0);
             }
             glm::mat4 model = glm::translate(identity, light_positions[i]);
-            GLuint model_location = glGetUniformLocation(light_program, "model");
-            glUniformMatrix4fv(model_location, 1, GL_FALSE, &model[0][0]);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            light_uniforms.set_M4fv("model", model);
+            cube_mesh.draw();
         }
+        profiler().end_frame();
         glfwPollEvents();
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report("Showcase 24");
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
@@ -0,0 +1,311 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "bounding_volume.h"
+#include "spatial_grid.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The kinds of objects that can be spawned into the scene.
+ */
+enum entity_type : uint8_t{
+    ENTITY_POINT_LIGHT = 0,
+    ENTITY_NORMAL_CUBE,
+    ENTITY_MIXED_CUBE,
+    ENTITY_NORMAL_MAP_CUBE,
+    ENTITY_TYPE_COUNT
+};
+
+/**
+ * @brief Stable reference to an entity. The generation tells apart entities that reused the same slot.
+ */
+struct entity_handle{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+/**
+ * @brief Point light parameters, only meaningful for ENTITY_POINT_LIGHT entities.
+ */
+struct light_params{
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(0.0f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    float constant = 1.0f;
+    float linear = 0.0f;
+    float quadratic = 0.0f;
+    bool enabled = false;
+};
+
+/**
+ * @brief Structure-of-arrays storage for the spawned objects.
+ * Components live in dense parallel arrays indexed from 0 to size() - 1 so that update and render
+ * passes stream over contiguous memory. Removal is deferred: destroy() only queues the entity and
+ * flush_removals() swaps the last entity into each hole at the end of the frame, which changes the
+ * dense index of the moved entity but never its handle.
+ * The simulation state is double-buffered: begin_step() keeps the positions of the last step so that the renderer can
+ * place the models between the last two steps.
+ * The world bounds are also kept in a spatial grid, keyed by the entity's slot, for proximity queries and picking.
+ */
+class entity_store{
+public:
+    std::vector<glm::vec3> positions; // simulation state after the last step
+    std::vector<glm::vec3> previous_positions; // simulation state before the last step
+    std::vector<glm::mat4> models; // interpolated between the two states, what the renderer draws
+    std::vector<entity_type> types;
+    std::vector<int> materials; // index of the instance batch the entity is drawn with
+    std::vector<light_params> lights;
+    std::vector<bounding_sphere> local_bounds; // bounds of the mesh the entity is drawn with
+    std::vector<bounding_sphere> bounds; // world space, kept up to date by whoever moves the entity
+
+    /**
+     * @brief Adds an entity with its components.
+     * @param type The entity type.
+     * @param position The initial position.
+     * @param material The instance batch the entity is drawn with.
+     * @param mesh_bounds The model space bounds of the mesh the entity is drawn with.
+     * @param light The light parameters, ignored by non light entities.
+     * @return The handle of the new entity.
+     */
+    entity_handle create(entity_type type, glm::vec3 position, int material, const bounding_sphere& mesh_bounds, const light_params& light = light_params());
+    /**
+     * @brief Starts a simulation step: the current positions become the previous ones.
+     */
+    void begin_step();
+    /**
+     * @brief Moves every entity to its current world bounds in the spatial grid, call it after the bounds change.
+     */
+    void update_index();
+    /**
+     * @brief Returns the spatial grid over the world bounds, its ids are entity slots.
+     */
+    const spatial_grid& index() const;
+    /**
+     * @brief Returns the dense index of the entity in a slot returned by the spatial grid.
+     */
+    int slot_to_dense(uint32_t slot) const;
+    /**
+     * @brief Queues an entity for removal at the next flush_removals(). Stale or already queued handles are ignored.
+     * @param handle The entity to remove.
+     */
+    void destroy(entity_handle handle);
+    /**
+     * @brief Removes every queued entity with swap-and-pop.
+     */
+    void flush_removals();
+    /**
+     * @brief Returns true if the handle refers to a live entity (queued entities are still alive until the flush).
+     */
+    bool alive(entity_handle handle) const;
+    /**
+     * @brief Returns the dense index of a live entity, or -1 for a stale handle.
+     */
+    int dense_index(entity_handle handle) const;
+    /**
+     * @brief Returns the handle of the entity at a dense index.
+     */
+    entity_handle handle_at(int dense) const;
+    /**
+     * @brief Returns the number of live entities.
+     */
+    int size() const;
+    /**
+     * @brief Returns the number of live entities of one type.
+     */
+    int count(entity_type type) const;
+    /**
+     * @brief Removes every entity at once, invalidating all handles.
+     */
+    void clear();
+    /**
+     * @brief Allocates room for a number of entities up front, so that spawning and removing up to that many entities
+     * never grows the component arrays, the slot table or the spatial grid.
+     * @param capacity The most entities expected alive at once.
+     */
+    void reserve(int capacity);
+private:
+    struct slot{
+        uint32_t dense;
+        uint32_t generation;
+        bool pending_removal;
+    };
+    void move_components(int from, int to);
+    void pop_components();
+
+    std::vector<slot> slots;
+    std::vector<uint32_t> dense_to_slot;
+    std::vector<uint32_t> free_slots;
+    std::vector<uint32_t> pending;
+    spatial_grid grid;
+    int type_counts[ENTITY_TYPE_COUNT] = {};
+};
+
+entity_handle entity_store::create(entity_type type, glm::vec3 position, int material, const bounding_sphere& mesh_bounds, const light_params& light){
+    uint32_t slot_index;
+    if(!free_slots.empty()){
+        slot_index = free_slots.back();
+        free_slots.pop_back();
+    }else{
+        slot_index = uint32_t(slots.size());
+        slots.push_back(slot{0, 0, false});
+    }
+    slot& entry = slots[slot_index];
+    entry.dense = uint32_t(positions.size());
+    entry.pending_removal = false;
+
+    positions.push_back(position);
+    previous_positions.push_back(position);
+    models.push_back(glm::translate(glm::mat4(1.0f), position));
+    types.push_back(type);
+    materials.push_back(material);
+    lights.push_back(light);
+    local_bounds.push_back(mesh_bounds);
+    bounds.push_back(transform_bounds(mesh_bounds, models.back()));
+    dense_to_slot.push_back(slot_index);
+    grid.insert(slot_index, bounds.back());
+    type_counts[type]++;
+
+    entity_handle handle;
+    handle.index = slot_index;
+    handle.generation = entry.generation;
+    return handle;
+}
+
+void entity_store::begin_step(){
+    previous_positions = positions;
+}
+
+void entity_store::update_index(){
+    grid.update(dense_to_slot.data(), bounds.data(), size());
+}
+
+const spatial_grid& entity_store::index() const{
+    return grid;
+}
+
+int entity_store::slot_to_dense(uint32_t slot) const{
+    return int(slots[slot].dense);
+}
+
+void entity_store::destroy(entity_handle handle){
+    if(!alive(handle) || slots[handle.index].pending_removal){
+        return;
+    }
+    slots[handle.index].pending_removal = true;
+    pending.push_back(handle.index);
+}
+
+void entity_store::flush_removals(){
+    for(uint32_t slot_index : pending){
+        slot& entry = slots[slot_index];
+        int hole = int(entry.dense);
+        int last = size() - 1;
+        type_counts[types[hole]]--;
+        grid.remove(slot_index);
+        if(hole != last){
+            move_components(last, hole);
+            uint32_t moved_slot = dense_to_slot[last];
+            dense_to_slot[hole] = moved_slot;
+            slots[moved_slot].dense = uint32_t(hole);
+        }
+        pop_components();
+        entry.generation++;
+        entry.pending_removal = false;
+        free_slots.push_back(slot_index);
+    }
+    pending.clear();
+}
+
+bool entity_store::alive(entity_handle handle) const{
+    return handle.index < slots.size() && slots[handle.index].generation == handle.generation
+        && slots[handle.index].dense < dense_to_slot.size() && dense_to_slot[slots[handle.index].dense] == handle.index;
+}
+
+int entity_store::dense_index(entity_handle handle) const{
+    return alive(handle) ? int(slots[handle.index].dense) : -1;
+}
+
+entity_handle entity_store::handle_at(int dense) const{
+    entity_handle handle;
+    handle.index = dense_to_slot[dense];
+    handle.generation = slots[handle.index].generation;
+    return handle;
+}
+
+int entity_store::size() const{
+    return int(positions.size());
+}
+
+int entity_store::count(entity_type type) const{
+    return type_counts[type];
+}
+
+void entity_store::clear(){
+    for(slot& entry : slots){
+        entry.generation++;
+        entry.pending_removal = false;
+    }
+    free_slots.clear();
+    for(uint32_t i = uint32_t(slots.size()); i > 0; i--){
+        free_slots.push_back(i - 1);
+    }
+    positions.clear();
+    previous_positions.clear();
+    models.clear();
+    types.clear();
+    materials.clear();
+    lights.clear();
+    local_bounds.clear();
+    bounds.clear();
+    dense_to_slot.clear();
+    pending.clear();
+    grid.clear();
+    for(int& type_count : type_counts){
+        type_count = 0;
+    }
+}
+
+void entity_store::reserve(int capacity){
+    size_t count = size_t(capacity);
+    positions.reserve(count);
+    previous_positions.reserve(count);
+    models.reserve(count);
+    types.reserve(count);
+    materials.reserve(count);
+    lights.reserve(count);
+    local_bounds.reserve(count);
+    bounds.reserve(count);
+    slots.reserve(count);
+    dense_to_slot.reserve(count);
+    free_slots.reserve(count);
+    pending.reserve(count);
+    grid.reserve(capacity);
+}
+
+void entity_store::move_components(int from, int to){
+    positions[to] = positions[from];
+    previous_positions[to] = previous_positions[from];
+    models[to] = models[from];
+    types[to] = types[from];
+    materials[to] = materials[from];
+    lights[to] = lights[from];
+    local_bounds[to] = local_bounds[from];
+    bounds[to] = bounds[from];
+}
+
+void entity_store::pop_components(){
+    positions.pop_back();
+    previous_positions.pop_back();
+    models.pop_back();
+    types.pop_back();
+    materials.pop_back();
+    lights.pop_back();
+    local_bounds.pop_back();
+    bounds.pop_back();
+    dense_to_slot.pop_back();
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <vector>
+#include "showcase3_functions.h"
+#include "entity_store.h"
+#include "light_clusters.h"
+
+// Binding points shared by every Showcase3 shader, see the camera_data/light_data blocks in res/Shaders
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHT_BLOCK_BINDING = 1;
+const int MAX_DIR_LIGHTS = 16;
+
+/**
+ * @brief std140 mirror of the camera_data uniform block.
+ */
+struct camera_block{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 camera_position;
+};
+
+/**
+ * @brief std140 mirror of dir_light_source in the light_data block. direction.w holds the enabled flag.
+ */
+struct gpu_dir_light{
+    glm::vec4 direction;
+    glm::vec4 ambient_color;
+    glm::vec4 diffuse_color;
+    glm::vec4 specular_color;
+};
+
+/**
+ * @brief std140 mirror of the light_data uniform block. light_counts holds (point lights, directional lights, 0, 0)
+ * and cluster_depth the depth slicing of the light clusters, the point lights themselves live in light_clusters.
+ */
+struct light_block{
+    glm::ivec4 light_counts;
+    glm::vec4 cluster_depth;
+    gpu_dir_light dir_sources[MAX_DIR_LIGHTS];
+};
+
+// std140 rules: vec4/mat4 columns are 16 byte aligned and structs round up to 16 bytes
+static_assert(sizeof(glm::vec4) == 16 && sizeof(glm::mat4) == 64, "glm types must be tightly packed for std140 mirrors");
+static_assert(offsetof(camera_block, projection) == 64, "camera_block layout does not match std140");
+static_assert(offsetof(camera_block, camera_position) == 128, "camera_block layout does not match std140");
+static_assert(sizeof(camera_block) == 144, "camera_block size does not match std140");
+static_assert(sizeof(gpu_dir_light) == 64, "gpu_dir_light size does not match std140");
+static_assert(offsetof(light_block, cluster_depth) == 16, "light_block layout does not match std140");
+static_assert(offsetof(light_block, dir_sources) == 32, "light_block layout does not match std140");
+static_assert(sizeof(light_block) == 32 + 64 * MAX_DIR_LIGHTS, "light_block size does not match std140");
+
+/**
+ * @brief Owns the per-frame camera and light uniform buffers and keeps them bound to their binding points.
+ * Point lights are binned into the light clusters with the camera of the last update_camera call.
+ */
+class frame_uniforms{
+public:
+    /**
+     * @brief Creates both buffers and the light clusters and registers the block and sampler bindings with the program library.
+     */
+    void create();
+    /**
+     * @brief Uploads the camera state for this frame.
+     * @param view The view matrix.
+     * @param projection The projection matrix.
+     * @param camera_position The position of the camera.
+     */
+    void update_camera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& camera_position);
+    /**
+     * @brief Uploads the light state for this frame.
+     * @param dir_sources Vector of directional light sources.
+     * @param scene The spawned entities, its enabled ENTITY_POINT_LIGHT entities become the point lights.
+     */
+    void update_lights(const std::vector<directional_light_source>& dir_sources, const entity_store& scene);
+    /**
+     * @brief Returns the clusters built by the last update_lights call.
+     */
+    const light_clusters& clusters() const;
+    /**
+     * @brief Returns the spheres lit by the point lights of the last update_lights call.
+     * @param spheres Receives one sphere per point light, its center and range.
+     */
+    void point_light_reach(std::vector<bounding_sphere>& spheres) const;
+private:
+    GLuint camera_UBO = 0;
+    GLuint light_UBO = 0;
+    light_block lights;
+    glm::mat4 camera_view = glm::mat4(1.0f);
+    glm::mat4 camera_projection = glm::mat4(1.0f);
+    std::vector<gpu_point_light> point_lights;
+    light_clusters light_grid;
+};
+
+void frame_uniforms::create(){
+    glGenBuffers(1, &camera_UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, camera_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(camera_block), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &light_UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, light_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(light_block), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, camera_UBO);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, light_UBO);
+    program_library().set_block_binding("camera_data", CAMERA_BLOCK_BINDING);
+    program_library().set_block_binding("light_data", LIGHT_BLOCK_BINDING);
+
+    light_grid.create();
+    program_library().set_sampler_binding("point_light_texels", POINT_LIGHT_TEXTURE_UNIT);
+    program_library().set_sampler_binding("cluster_texels", CLUSTER_TEXTURE_UNIT);
+    program_library().set_sampler_binding("light_index_texels", LIGHT_INDEX_TEXTURE_UNIT);
+}
+
+void frame_uniforms::update_camera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& camera_position){
+    camera_view = view;
+    camera_projection = projection;
+    camera_block camera;
+    camera.view = view;
+    camera.projection = projection;
+    camera.camera_position = glm::vec4(camera_position, 1.0f);
+    glBindBuffer(GL_UNIFORM_BUFFER, camera_UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera_block), &camera);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void frame_uniforms::update_lights(const std::vector<directional_light_source>& dir_sources, const entity_store& scene){
+    int dir_count = int(dir_sources.size()) < MAX_DIR_LIGHTS ? int(dir_sources.size()) : MAX_DIR_LIGHTS;
+    for(int i = 0; i < dir_count; i++){
+        const directional_light_source& source = dir_sources[i];
+        gpu_dir_light& light = lights.dir_sources[i];
+        light.direction = glm::vec4(source.direction, source.enabled ? 1.0f : 0.0f);
+        light.ambient_color = glm::vec4(source.ambient, 0.0f);
+        light.diffuse_color = glm::vec4(source.diffuse, 0.0f);
+        light.specular_color = glm::vec4(source.specular, 0.0f);
+    }
+    // Disabled lights contribute nothing, so they are not even binned
+    point_lights.clear();
+    for(int i = 0; i < scene.size() && int(point_lights.size()) < MAX_POINT_LIGHTS; i++){
+        if(scene.types[i] != ENTITY_POINT_LIGHT || !scene.lights[i].enabled){
+            continue;
+        }
+        const light_params& source = scene.lights[i];
+        gpu_point_light light;
+        light.ambient_color = glm::vec4(source.ambient, 0.0f);
+        light.diffuse_color = glm::vec4(source.diffuse, 0.0f);
+        light.specular_color = glm::vec4(source.specular, 0.0f);
+        light.attenuation = glm::vec4(source.constant, source.linear, source.quadratic, 0.0f);
+        light.position = glm::vec4(glm::vec3(scene.models[i][3]), light_range(light)); // where the light is drawn this frame
+        point_lights.push_back(light);
+    }
+    light_grid.build(camera_view, camera_projection, point_lights);
+    lights.light_counts = glm::ivec4(light_grid.light_count(), dir_count, 0, 0);
+    lights.cluster_depth = light_grid.depth_params();
+    // Only the used part of the array is uploaded, the shaders never read past light_counts
+    size_t upload_size = offsetof(light_block, dir_sources) + sizeof(gpu_dir_light) * dir_count;
+    glBindBuffer(GL_UNIFORM_BUFFER, light_UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, upload_size, &lights);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void frame_uniforms::point_light_reach(std::vector<bounding_sphere>& spheres) const{
+    spheres.clear();
+    for(const gpu_point_light& light : point_lights){
+        spheres.push_back(bounding_sphere{glm::vec3(light.position), light.position.w});
+    }
+}
+
+const light_clusters& frame_uniforms::clusters() const{
+    return light_grid;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef INSTANCE_BATCH_H
+#define INSTANCE_BATCH_H
+
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "shader_library.h"
+#include "mesh_registry.h"
+#include "render_queue.h"
+#include "texture_array.h"
+
+// Attribute locations of the per-instance data, after the mesh attributes (0-4) used by the Showcase3 shaders
+const GLuint INSTANCE_MODEL_LOCATION = 5; // mat4 takes locations 5 to 8
+const GLuint INSTANCE_ENABLED_LOCATION = 9;
+const GLuint INSTANCE_LAYERS_LOCATION = 10;
+
+/**
+ * @brief Per-instance data streamed to the GPU, read by the INSTANCED variants of the shaders.
+ */
+struct instance_data{
+    glm::mat4 model;
+    float enabled;
+    glm::vec2 layers; // the texture array layers of the first and second material texture
+};
+
+/**
+ * @brief Returns the defines of the instanced variant of a program, the one an instance_batch acquires.
+ * @param defines Semicolon separated list of defines of the program.
+ */
+std::string instanced_defines(const std::string& defines){
+    return defines.empty() ? "INSTANCED" : "INSTANCED;" + defines;
+}
+
+/**
+ * @brief Draws every object of one type with a single glDrawElementsInstanced call, submitted as one item of the render queue.
+ * The batch shares the mesh from the mesh registry and owns the instance buffer and an INSTANCED variant of the type's program;
+ * the objects only have to add their model matrix every frame. Material textures come from one texture array, every
+ * instance picks its own layers, so instances with different images still share the draw.
+ */
+class instance_batch{
+public:
+    /**
+     * @brief Compiles the instanced program and sets up a VAO over the shared mesh and the instance buffer.
+     * @param shared_mesh The mesh from the mesh registry.
+     * @param vertex_path Path to the vertex shader.
+     * @param fragment_path Path to the fragment shader.
+     * @param defines Semicolon separated list of defines of the program, INSTANCED is added to them.
+     */
+    void create(const gpu_mesh& shared_mesh, std::string vertex_path, std::string fragment_path, const std::string& defines = "");
+    /**
+     * @brief Assigns the texture array bound to unit 0 while drawing and the layers of the instances added without their own.
+     * @param array The texture array.
+     * @param layer1 Layer of the first texture.
+     * @param layer2 Layer of the second texture.
+     */
+    void assign_textures(const texture_array& array, int layer1, int layer2);
+    /**
+     * @brief Sets an integer uniform that stays the same for every instance (e.g. a sampler unit).
+     * @param name The uniform name.
+     * @param value The value.
+     */
+    void set_material_1i(std::string_view name, int value);
+    /**
+     * @brief Sets a float uniform that stays the same for every instance (e.g. shininess).
+     * @param name The uniform name.
+     * @param value The value.
+     */
+    void set_material_1f(std::string_view name, float value);
+    /**
+     * @brief Clears the instances collected for the previous frame.
+     */
+    void begin();
+    /**
+     * @brief Adds one instance to this frame's draw.
+     * @param model The model matrix of the instance.
+     * @param enabled Per-instance flag, used by the light markers.
+     */
+    void add(const glm::mat4& model, bool enabled = true);
+    /**
+     * @brief Adds one instance to this frame's draw with its own texture array layers.
+     * @param model The model matrix of the instance.
+     * @param enabled Per-instance flag, used by the light markers.
+     * @param layers The layers of the first and second texture.
+     */
+    void add(const glm::mat4& model, bool enabled, const glm::vec2& layers);
+    /**
+     * @brief Queues the draw of every collected instance, the upload happens when the queue reaches it.
+     * @param queue The render queue of the frame.
+     */
+    void submit(render_queue& queue);
+    /**
+     * @brief Returns the number of instances collected for this frame.
+     */
+    int size() const;
+    /**
+     * @brief Sizes the instance list and the instance buffer for a number of instances up front, so that the batch never
+     * grows while the scene stays below it.
+     * @param count The number of instances.
+     */
+    void reserve(int count);
+private:
+    static void issue_draw(void* object);
+
+    GLuint VAO = 0;
+    GLuint instance_VBO = 0;
+    const gpu_mesh* mesh = nullptr;
+    shared_program shader;
+    int instance_capacity = 0;
+    GLuint texture = 0;
+    glm::vec2 default_layers = glm::vec2(0.0f);
+    std::vector<instance_data> instances;
+};
+
+void instance_batch::create(const gpu_mesh& shared_mesh, std::string vertex_path, std::string fragment_path, const std::string& defines){
+    shader = program_library().acquire(vertex_path, fragment_path, instanced_defines(defines));
+    mesh = &shared_mesh;
+
+    VAO = shared_mesh.create_VAO();
+    // The instance buffer starts empty and grows in issue_draw()
+    glGenBuffers(1, &instance_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_VBO);
+    for(GLuint column = 0; column < 4; column++){
+        glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+        glVertexAttribPointer(INSTANCE_MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(instance_data), (void*)(sizeof(glm::vec4) * column));
+        glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + column, 1);
+    }
+    glEnableVertexAttribArray(INSTANCE_ENABLED_LOCATION);
+    glVertexAttribPointer(INSTANCE_ENABLED_LOCATION, 1, GL_FLOAT, GL_FALSE, sizeof(instance_data), (void*)offsetof(instance_data, enabled));
+    glVertexAttribDivisor(INSTANCE_ENABLED_LOCATION, 1);
+    glEnableVertexAttribArray(INSTANCE_LAYERS_LOCATION);
+    glVertexAttribPointer(INSTANCE_LAYERS_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(instance_data), (void*)offsetof(instance_data, layers));
+    glVertexAttribDivisor(INSTANCE_LAYERS_LOCATION, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void instance_batch::assign_textures(const texture_array& array, int layer1, int layer2){
+    texture = array.id();
+    default_layers = glm::vec2(float(layer1), float(layer2));
+}
+
+void instance_batch::set_material_1i(std::string_view name, int value){
+    gl_state().use_program(shader->id);
+    shader->uniforms.set_1i(name, value);
+}
+
+void instance_batch::set_material_1f(std::string_view name, float value){
+    gl_state().use_program(shader->id);
+    shader->uniforms.set_1f(name, value);
+}
+
+void instance_batch::begin(){
+    instances.clear();
+}
+
+void instance_batch::add(const glm::mat4& model, bool enabled){
+    add(model, enabled, default_layers);
+}
+
+void instance_batch::add(const glm::mat4& model, bool enabled, const glm::vec2& layers){
+    instance_data instance;
+    instance.model = model;
+    instance.enabled = enabled ? 1.0f : 0.0f;
+    instance.layers = layers;
+    instances.push_back(instance);
+}
+
+void instance_batch::submit(render_queue& queue){
+    if(instances.empty()){
+        return;
+    }
+    draw_item item;
+    item.program = shader->id;
+    item.VAO = VAO;
+    item.texture1 = texture;
+    item.texture_target = GL_TEXTURE_2D_ARRAY;
+    item.issue = &instance_batch::issue_draw;
+    item.object = this;
+    queue.submit(item);
+}
+
+void instance_batch::issue_draw(void* object){
+    instance_batch& batch = *static_cast<instance_batch*>(object);
+    int count = int(batch.instances.size());
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instance_VBO);
+    if(count > batch.instance_capacity){
+        batch.instance_capacity = (count > batch.instance_capacity * 2) ? count : batch.instance_capacity * 2;
+    }
+    // Reallocating every frame orphans the old storage, so the upload does not wait for last frame's draw
+    glBufferData(GL_ARRAY_BUFFER, batch.instance_capacity * sizeof(instance_data), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(instance_data), batch.instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, batch.mesh->index_count, batch.mesh->index_type, (void*)0, count);
+}
+
+int instance_batch::size() const{
+    return int(instances.size());
+}
+
+void instance_batch::reserve(int count){
+    instances.reserve(size_t(count));
+    if(count > instance_capacity){
+        instance_capacity = count;
+    }
+}
+
+#endif
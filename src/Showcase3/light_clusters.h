@@ -0,0 +1,305 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "job_system.h"
+#include "gl_state_cache.h"
+
+// View space cluster grid: screen tiles on X/Y and exponential depth slices on Z, see cluster_lights() in the lit shaders
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+const int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const int MAX_POINT_LIGHTS = 1024;
+// Texture units the cluster buffers stay bound to, the materials use units 0 and 1
+const int POINT_LIGHT_TEXTURE_UNIT = 2;
+const int CLUSTER_TEXTURE_UNIT = 3;
+const int LIGHT_INDEX_TEXTURE_UNIT = 4;
+// A light stops being binned where its attenuated brightness drops below this fraction
+const float LIGHT_CUTOFF = 1.0f / 256.0f;
+
+/**
+ * @brief One point light as stored in the point light texture buffer, five RGBA32F texels per light.
+ * position.w holds the range used for binning, attenuation holds (constant, linear, quadratic, 0).
+ */
+struct gpu_point_light{
+    glm::vec4 position;
+    glm::vec4 ambient_color;
+    glm::vec4 diffuse_color;
+    glm::vec4 specular_color;
+    glm::vec4 attenuation;
+};
+static_assert(sizeof(gpu_point_light) == 5 * sizeof(glm::vec4), "gpu_point_light must be five tightly packed texels");
+
+/**
+ * @brief Returns the distance at which the attenuated brightest channel of the light falls under LIGHT_CUTOFF.
+ * @param light The light, its colors and attenuation must be filled.
+ */
+float light_range(const gpu_point_light& light){
+    glm::vec3 brightest = glm::max(glm::vec3(light.ambient_color), glm::max(glm::vec3(light.diffuse_color), glm::vec3(light.specular_color)));
+    float intensity = std::max(brightest.x, std::max(brightest.y, brightest.z));
+    float constant = light.attenuation.x - intensity / LIGHT_CUTOFF;
+    float linear = light.attenuation.y;
+    float quadratic = light.attenuation.z;
+    if(constant >= 0.0f){
+        return 0.0f; // never reaches the cutoff
+    }
+    if(quadratic <= 0.0f){
+        return linear > 0.0f ? -constant / linear : 1e30f;
+    }
+    return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * constant)) / (2.0f * quadratic);
+}
+
+/**
+ * @brief Bins point lights into view space clusters on the CPU and publishes the result as texture buffers:
+ * the lights themselves, a (first index, count) record per cluster and the flat list of light indices.
+ * The lit fragment shaders look up their cluster and only shade the lights listed for it.
+ */
+class light_clusters{
+public:
+    /**
+     * @brief Creates the buffers and their textures and binds them to their texture units.
+     */
+    void create();
+    /**
+     * @brief Bins the lights for this frame and uploads the cluster data.
+     * @param view The view matrix.
+     * @param projection The perspective projection matrix, the near and far planes are read from it.
+     * @param lights The enabled point lights, at most MAX_POINT_LIGHTS are used.
+     */
+    void build(const glm::mat4& view, const glm::mat4& projection, const std::vector<gpu_point_light>& lights);
+    /**
+     * @brief Returns (near, far, scale, bias) so that the depth slice of a view depth d is log(d) * scale - bias.
+     */
+    glm::vec4 depth_params() const;
+    /**
+     * @brief Returns the number of lights binned in the last build.
+     */
+    int light_count() const;
+    /**
+     * @brief Returns the number of light indices in the last build, i.e. the lights shaded summed over all clusters.
+     */
+    int light_references() const;
+private:
+    struct view_light{
+        glm::vec3 center;
+        float radius;
+        int first_tile_x, last_tile_x;
+        int first_tile_y, last_tile_y;
+        int first_slice, last_slice;
+    };
+    void compute_cluster_bounds(const glm::mat4& projection);
+    int depth_slice(float depth) const;
+    void bin_slice(int slice);
+    void bind_textures();
+
+    GLuint light_buffer = 0, light_texture = 0;
+    GLuint cluster_buffer = 0, cluster_texture = 0;
+    GLuint index_buffer = 0, index_texture = 0;
+    int index_capacity = 0;
+    int max_texels = 0;
+
+    glm::mat4 bounds_projection = glm::mat4(0.0f);
+    float near_plane = 0.1f;
+    float far_plane = 100.0f;
+    float slice_scale = 0.0f;
+    float slice_bias = 0.0f;
+    std::vector<glm::vec3> cluster_min; // view space bounding box of every cluster
+    std::vector<glm::vec3> cluster_max;
+
+    int binned_lights = 0;
+    std::vector<view_light> view_lights;
+    std::vector<std::vector<uint32_t>> cluster_lights;
+    std::vector<glm::uvec2> cluster_records;
+    std::vector<uint32_t> light_indices;
+};
+
+void light_clusters::create(){
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    index_capacity = std::min(4 * CLUSTER_COUNT, max_texels);
+
+    glGenBuffers(1, &light_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, light_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_POINT_LIGHTS * sizeof(gpu_point_light), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &cluster_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, cluster_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, index_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, index_capacity * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &light_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, light_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, light_buffer);
+    glGenTextures(1, &cluster_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, cluster_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, cluster_buffer);
+    glGenTextures(1, &index_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, index_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, index_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    cluster_lights.resize(CLUSTER_COUNT);
+    cluster_records.resize(CLUSTER_COUNT, glm::uvec2(0));
+    bind_textures();
+}
+
+void light_clusters::build(const glm::mat4& view, const glm::mat4& projection, const std::vector<gpu_point_light>& lights){
+    if(projection != bounds_projection){
+        compute_cluster_bounds(projection);
+    }
+    int light_count = std::min(int(lights.size()), MAX_POINT_LIGHTS);
+
+    // Find the range of clusters each light can touch
+    view_lights.clear();
+    for(int i = 0; i < light_count; i++){
+        view_light light;
+        light.center = glm::vec3(view * glm::vec4(glm::vec3(lights[i].position), 1.0f));
+        light.radius = lights[i].position.w;
+        float nearest = -light.center.z - light.radius;
+        float farthest = -light.center.z + light.radius;
+        if(light.radius <= 0.0f || farthest < near_plane || nearest > far_plane){
+            view_lights.push_back(view_light{light.center, light.radius, 0, -1, 0, -1, 0, -1});
+            continue;
+        }
+        light.first_slice = nearest <= near_plane ? 0 : depth_slice(nearest);
+        light.last_slice = farthest >= far_plane ? CLUSTER_Z - 1 : depth_slice(farthest);
+        light.first_tile_x = 0;
+        light.last_tile_x = CLUSTER_X - 1;
+        light.first_tile_y = 0;
+        light.last_tile_y = CLUSTER_Y - 1;
+        if(nearest > near_plane){
+            // The sphere is fully in front of the camera, project its bounding box to narrow the tiles
+            glm::vec2 low(1e30f), high(-1e30f);
+            for(int corner = 0; corner < 8; corner++){
+                glm::vec3 point = light.center + light.radius * glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+                glm::vec2 ndc(projection[0][0] * point.x / -point.z, projection[1][1] * point.y / -point.z);
+                low = glm::min(low, ndc);
+                high = glm::max(high, ndc);
+            }
+            light.first_tile_x = std::max(0, int(std::floor((low.x * 0.5f + 0.5f) * CLUSTER_X)));
+            light.last_tile_x = std::min(CLUSTER_X - 1, int(std::floor((high.x * 0.5f + 0.5f) * CLUSTER_X)));
+            light.first_tile_y = std::max(0, int(std::floor((low.y * 0.5f + 0.5f) * CLUSTER_Y)));
+            light.last_tile_y = std::min(CLUSTER_Y - 1, int(std::floor((high.y * 0.5f + 0.5f) * CLUSTER_Y)));
+        }
+        view_lights.push_back(light);
+    }
+
+    // Every slice owns its clusters, so the slices can be binned in parallel
+    job_pool().parallel_for(CLUSTER_Z, 1, [this](int begin, int end){
+        for(int slice = begin; slice < end; slice++){
+            bin_slice(slice);
+        }
+    });
+
+    // Flatten the per cluster lists, clusters past the texture buffer limit lose their extra lights
+    light_indices.clear();
+    for(int cluster = 0; cluster < CLUSTER_COUNT; cluster++){
+        const std::vector<uint32_t>& list = cluster_lights[cluster];
+        int count = std::min(int(list.size()), max_texels - int(light_indices.size()));
+        cluster_records[cluster] = glm::uvec2(uint32_t(light_indices.size()), uint32_t(count));
+        light_indices.insert(light_indices.end(), list.begin(), list.begin() + count);
+    }
+    binned_lights = light_count;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, light_buffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, light_count * sizeof(gpu_point_light), lights.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, cluster_buffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, CLUSTER_COUNT * sizeof(glm::uvec2), cluster_records.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, index_buffer);
+    if(int(light_indices.size()) > index_capacity){
+        index_capacity = std::min(std::max(int(light_indices.size()), index_capacity * 2), max_texels);
+    }
+    // Reallocating orphans last frame's list, so the upload does not wait for its draws
+    glBufferData(GL_TEXTURE_BUFFER, index_capacity * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, light_indices.size() * sizeof(uint32_t), light_indices.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    bind_textures();
+}
+
+glm::vec4 light_clusters::depth_params() const{
+    return glm::vec4(near_plane, far_plane, slice_scale, slice_bias);
+}
+
+int light_clusters::light_count() const{
+    return binned_lights;
+}
+
+int light_clusters::light_references() const{
+    return int(light_indices.size());
+}
+
+void light_clusters::compute_cluster_bounds(const glm::mat4& projection){
+    bounds_projection = projection;
+    // glm::perspective: [2][2] = -(f + n) / (f - n), [3][2] = -2fn / (f - n)
+    near_plane = projection[3][2] / (projection[2][2] - 1.0f);
+    far_plane = projection[3][2] / (projection[2][2] + 1.0f);
+    slice_scale = CLUSTER_Z / std::log(far_plane / near_plane);
+    slice_bias = std::log(near_plane) * slice_scale;
+
+    cluster_min.resize(CLUSTER_COUNT);
+    cluster_max.resize(CLUSTER_COUNT);
+    for(int z = 0; z < CLUSTER_Z; z++){
+        float depth_near = near_plane * std::pow(far_plane / near_plane, float(z) / CLUSTER_Z);
+        float depth_far = near_plane * std::pow(far_plane / near_plane, float(z + 1) / CLUSTER_Z);
+        for(int y = 0; y < CLUSTER_Y; y++){
+            for(int x = 0; x < CLUSTER_X; x++){
+                glm::vec2 ndc_low(-1.0f + 2.0f * x / CLUSTER_X, -1.0f + 2.0f * y / CLUSTER_Y);
+                glm::vec2 ndc_high(-1.0f + 2.0f * (x + 1) / CLUSTER_X, -1.0f + 2.0f * (y + 1) / CLUSTER_Y);
+                glm::vec3 low(1e30f), high(-1e30f);
+                for(float depth : {depth_near, depth_far}){
+                    for(glm::vec2 ndc : {ndc_low, ndc_high}){
+                        glm::vec3 point(ndc.x * depth / projection[0][0], ndc.y * depth / projection[1][1], -depth);
+                        low = glm::min(low, point);
+                        high = glm::max(high, point);
+                    }
+                }
+                int cluster = x + CLUSTER_X * (y + CLUSTER_Y * z);
+                cluster_min[cluster] = low;
+                cluster_max[cluster] = high;
+            }
+        }
+    }
+}
+
+int light_clusters::depth_slice(float depth) const{
+    int slice = int(std::floor(std::log(depth) * slice_scale - slice_bias));
+    return std::min(std::max(slice, 0), CLUSTER_Z - 1);
+}
+
+void light_clusters::bin_slice(int slice){
+    for(int cluster = slice * CLUSTER_X * CLUSTER_Y; cluster < (slice + 1) * CLUSTER_X * CLUSTER_Y; cluster++){
+        cluster_lights[cluster].clear();
+    }
+    for(uint32_t i = 0; i < uint32_t(view_lights.size()); i++){
+        const view_light& light = view_lights[i];
+        if(slice < light.first_slice || slice > light.last_slice){
+            continue;
+        }
+        for(int y = light.first_tile_y; y <= light.last_tile_y; y++){
+            for(int x = light.first_tile_x; x <= light.last_tile_x; x++){
+                int cluster = x + CLUSTER_X * (y + CLUSTER_Y * slice);
+                // Sphere against the cluster's box
+                glm::vec3 closest = glm::clamp(light.center, cluster_min[cluster], cluster_max[cluster]);
+                glm::vec3 offset = closest - light.center;
+                if(glm::dot(offset, offset) <= light.radius * light.radius){
+                    cluster_lights[cluster].push_back(i);
+                }
+            }
+        }
+    }
+}
+
+void light_clusters::bind_textures(){
+    gl_state().bind_texture(POINT_LIGHT_TEXTURE_UNIT, GL_TEXTURE_BUFFER, light_texture);
+    gl_state().bind_texture(CLUSTER_TEXTURE_UNIT, GL_TEXTURE_BUFFER, cluster_texture);
+    gl_state().bind_texture(LIGHT_INDEX_TEXTURE_UNIT, GL_TEXTURE_BUFFER, index_texture);
+}
+
+#endif
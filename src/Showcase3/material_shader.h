@@ -0,0 +1,44 @@
+#ifndef MATERIAL_SHADER_H
+#define MATERIAL_SHADER_H
+
+#include <string>
+#include "shader_library.h"
+
+// The uber shader every Showcase3 material is drawn with, its features are chosen with #define permutations
+const char* const MATERIAL_VERTEX_SHADER = "./res/Shaders/MaterialVertexShader_31.txt";
+const char* const MATERIAL_FRAGMENT_SHADER = "./res/Shaders/MaterialFragmentShader_31.txt";
+
+/**
+ * @brief Features of the material uber shader, combined as bit flags. Without any flag the first texture is lit.
+ */
+enum material_feature : unsigned{
+    MATERIAL_UNLIT = 1 << 0, // the first texture is shown without lighting
+    MATERIAL_DIFFUSE_MAP = 1 << 1, // the second texture lights the diffuse term
+    MATERIAL_MIX_MAP = 1 << 2, // the two textures are mixed by the mix_percentage uniform
+    MATERIAL_NORMAL_MAP = 1 << 3 // the second texture is a tangent space normal map, the mesh needs tangents
+};
+
+/**
+ * @brief Returns the defines of a material permutation, in a fixed order so that every user of the same features
+ * shares one program in the shader library and one binary in the program binary cache.
+ * @param features The material_feature flags.
+ * @return Semicolon separated list of defines, as taken by shader_library::acquire().
+ */
+std::string material_defines(unsigned features){
+    const struct{ unsigned feature; const char* define; } names[] = {
+        {MATERIAL_UNLIT, "UNLIT"},
+        {MATERIAL_DIFFUSE_MAP, "DIFFUSE_MAP"},
+        {MATERIAL_MIX_MAP, "MIX_MAP"},
+        {MATERIAL_NORMAL_MAP, "NORMAL_MAP"}
+    };
+    std::string defines;
+    for(const auto& name : names){
+        if(features & name.feature){
+            defines += defines.empty() ? "" : ";";
+            defines += name.define;
+        }
+    }
+    return defines;
+}
+
+#endif
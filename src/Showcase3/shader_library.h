@@ -0,0 +1,432 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <GL/glew.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "uniform_table.h"
+#include "gl_state_cache.h"
+#include "program_binary_cache.h"
+
+// Cleared by terminate() so that programs released after the context is gone do not call into GL.
+static bool shader_context_alive = true;
+
+/**
+ * @brief Reads a shader file from the given path.
+ * @param path The path to the shader file.
+ * @return The content of the shader file as a string.
+ */
+std::string read_shader(const char* path){
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Shader file '" << path << "' not found or failed to open!\n";
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    if (buffer.str().empty()) {
+        std::cerr << "Error: Shader file '" << path << "' is empty!" << std::endl;
+    }
+
+    return buffer.str();
+}
+
+/**
+ * @brief Inserts #define lines right after the #version directive of a shader source.
+ * @param source The shader source code.
+ * @param defines Semicolon separated list of defines, each either "NAME" or "NAME VALUE".
+ * @return The shader source with the defines injected.
+ */
+std::string inject_defines(const std::string& source, const std::string& defines){
+    if(defines.empty()){
+        return source;
+    }
+    std::string block;
+    std::stringstream list(defines);
+    std::string define;
+    while(std::getline(list, define, ';')){
+        if(!define.empty()){
+            block += "#define " + define + "\n";
+        }
+    }
+    // #version has to stay the first statement, so the defines go on the line after it
+    size_t insert_at = 0;
+    if(source.compare(0, 8, "#version") == 0){
+        insert_at = source.find('\n');
+        insert_at = (insert_at == std::string::npos) ? source.size() : insert_at + 1;
+    }
+    std::string result = source;
+    result.insert(insert_at, block);
+    return result;
+}
+
+/**
+ * @brief Starts compiling a shader from source code. The status is read by check_shader(), so that a driver with
+ * parallel compilation can keep working on it while the other shaders are issued.
+ * @param type The type of shader (e.g., GL_VERTEX_SHADER, GL_FRAGMENT_SHADER).
+ * @param source The source code of the shader.
+ * @return The ID of the shader.
+ */
+GLuint compile_shader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+/**
+ * @brief Prints the log of a shader that failed to compile, this waits for its compilation.
+ * @param shader The ID of the shader.
+ */
+void check_shader(GLuint shader){
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cout << "Shader compilation failed:\n" << infoLog << "\n";
+    }
+}
+
+/**
+ * @brief A program whose compilation and link have been issued, but whose status has not been read yet.
+ */
+struct program_build{
+    GLuint program = 0;
+    GLuint vertex_shader = 0;
+    GLuint fragment_shader = 0;
+    uint64_t key = 0;
+    bool from_binary = false;
+};
+
+/**
+ * @brief Issues the compilation and link of a program without waiting for any of them.
+ * A program this driver has linked from the same sources before is loaded from program_binaries() instead of being compiled.
+ * @param vertex_path Path to the vertex shader file.
+ * @param fragment_path Path to the fragment shader file.
+ * @param defines Semicolon separated list of defines injected into both stages.
+ * @return The build, to be completed by finish_program_build().
+ */
+program_build begin_program_build(const char* vertex_path, const char* fragment_path, const std::string& defines = ""){
+    std::string s1 = inject_defines(read_shader(vertex_path), defines);
+    std::string s2 = inject_defines(read_shader(fragment_path), defines);
+    program_build build;
+    build.key = program_binaries().make_key(s1, s2);
+    build.program = program_binaries().load(build.key);
+    if(build.program != 0){
+        build.from_binary = true;
+        return build;
+    }
+    build.vertex_shader = compile_shader(GL_VERTEX_SHADER, s1.c_str());
+    build.fragment_shader = compile_shader(GL_FRAGMENT_SHADER, s2.c_str());
+
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertex_shader);
+    glAttachShader(build.program, build.fragment_shader);
+    program_binaries().prepare(build.program);
+    glLinkProgram(build.program);
+    return build;
+}
+
+/**
+ * @brief Returns true if the driver is done with a build, so finishing it does not block.
+ * Without GL_KHR_parallel_shader_compile the driver cannot tell and every build counts as done.
+ * @param build The build.
+ */
+bool program_build_ready(const program_build& build){
+    if(build.from_binary || !GLEW_KHR_parallel_shader_compile){
+        return true;
+    }
+    GLint complete = GL_TRUE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+/**
+ * @brief Reads the status of a build, prints the logs of failed stages and stores the binary of a successful link.
+ * @param build The build.
+ * @return The ID of the program.
+ */
+GLuint finish_program_build(program_build& build){
+    if(build.from_binary){
+        return build.program;
+    }
+    check_shader(build.vertex_shader);
+    check_shader(build.fragment_shader);
+    int success;
+    char infoLog[512];
+    glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(build.program, 512, nullptr, infoLog);
+        std::cout << "Shader linking failed:\n" << infoLog << std::endl;
+    }else{
+        program_binaries().store(build.key, build.program);
+    }
+
+    glDeleteShader(build.vertex_shader);
+    glDeleteShader(build.fragment_shader);
+    build.vertex_shader = 0;
+    build.fragment_shader = 0;
+    return build.program;
+}
+
+/**
+ * @brief Creates a shader program from vertex and fragment shader paths, waiting for it to be linked.
+ * A program this driver has linked from the same sources before is loaded from program_binaries() instead of being compiled.
+ * @param vertex_path Path to the vertex shader file.
+ * @param fragment_path Path to the fragment shader file.
+ * @param defines Semicolon separated list of defines injected into both stages.
+ * @return The ID of the created shader program.
+ */
+GLuint create_shader_program(const char* vertex_path, const char* fragment_path, const std::string& defines = "") {
+    program_build build = begin_program_build(vertex_path, fragment_path, defines);
+    return finish_program_build(build);
+}
+
+/**
+ * @brief A linked shader program shared by every object built from the same sources, together with its uniform table.
+ * The GL program is deleted when the last handle to it is released.
+ */
+struct shader_program{
+    GLuint id = 0;
+    std::string key;
+    uniform_table uniforms;
+    ~shader_program(){
+        if(id != 0 && shader_context_alive){
+            glDeleteProgram(id);
+        }
+    }
+};
+
+typedef std::shared_ptr<shader_program> shared_program;
+
+/**
+ * @brief Compiles each (vertex, fragment, defines) combination once and hands out shared handles to it.
+ * Programs known up front are queued with preload() and built together by compile_pending(): every compilation and
+ * link is issued before the first status is read, so a driver with GL_KHR_parallel_shader_compile builds them on its own
+ * threads, and the results are collected in the order they complete.
+ */
+class shader_library{
+public:
+    /**
+     * @brief Returns the program for the given sources, compiling it only if no live handle exists.
+     * @param vertex_path Path to the vertex shader.
+     * @param fragment_path Path to the fragment shader.
+     * @param defines Semicolon separated list of defines injected into both stages.
+     * @return A shared handle to the linked program.
+     */
+    shared_program acquire(const std::string& vertex_path, const std::string& fragment_path, const std::string& defines = "");
+    /**
+     * @brief Queues a program for the next compile_pending(), the library keeps it alive until it is acquired.
+     * @param vertex_path Path to the vertex shader.
+     * @param fragment_path Path to the fragment shader.
+     * @param defines Semicolon separated list of defines injected into both stages.
+     */
+    void preload(const std::string& vertex_path, const std::string& fragment_path, const std::string& defines = "");
+    /**
+     * @brief Builds every queued program, issuing all compilations and links before reading any status.
+     * acquire() calls it when programs are still queued.
+     */
+    void compile_pending();
+    /**
+     * @brief Binds a named uniform block to a fixed binding point in every program that declares it,
+     * including programs compiled later.
+     * @param block The uniform block name.
+     * @param binding The binding point.
+     */
+    void set_block_binding(const std::string& block, GLuint binding);
+    /**
+     * @brief Points a named sampler uniform to a fixed texture unit in every program that declares it,
+     * including programs compiled later. Used for textures that stay bound for the whole frame.
+     * @param sampler The sampler uniform name.
+     * @param unit The texture unit.
+     */
+    void set_sampler_binding(const std::string& sampler, int unit);
+    /**
+     * @brief Returns the number of programs that currently have at least one user.
+     */
+    int live_programs();
+    /**
+     * @brief Returns how many programs have been compiled since startup.
+     */
+    int compiled_programs() const;
+    /**
+     * @brief Returns the milliseconds spent creating programs since startup, whether compiled or loaded from binaries.
+     */
+    double creation_time() const;
+private:
+    // A program queued by preload()
+    struct pending_program{
+        std::string vertex_path;
+        std::string fragment_path;
+        std::string defines;
+        std::string key;
+    };
+
+    void register_program(const shared_program& program);
+    void apply_block_bindings(GLuint program);
+    void apply_sampler_bindings(shader_program& program);
+    // Only weak references are kept so that the last user, not the library, decides the program's lifetime
+    std::map<std::string, std::weak_ptr<shader_program>> programs;
+    std::vector<pending_program> pending;
+    std::vector<shared_program> preloaded; // built by compile_pending() and not acquired yet
+    std::map<std::string, GLuint> block_bindings;
+    std::map<std::string, int> sampler_bindings;
+    int compile_count = 0;
+    double creation_ms = 0.0;
+};
+
+shared_program shader_library::acquire(const std::string& vertex_path, const std::string& fragment_path, const std::string& defines){
+    compile_pending();
+    std::string key = vertex_path + "|" + fragment_path + "|" + defines;
+    auto found = programs.find(key);
+    if(found != programs.end()){
+        shared_program existing = found->second.lock();
+        if(existing){
+            // From now on its users decide its lifetime
+            preloaded.erase(std::remove(preloaded.begin(), preloaded.end(), existing), preloaded.end());
+            return existing;
+        }
+    }
+    shared_program program = std::make_shared<shader_program>();
+    auto start = std::chrono::steady_clock::now();
+    program->id = create_shader_program(vertex_path.c_str(), fragment_path.c_str(), defines);
+    creation_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    program->key = key;
+    register_program(program);
+    return program;
+}
+
+void shader_library::preload(const std::string& vertex_path, const std::string& fragment_path, const std::string& defines){
+    std::string key = vertex_path + "|" + fragment_path + "|" + defines;
+    auto found = programs.find(key);
+    if(found != programs.end() && !found->second.expired()){
+        return;
+    }
+    for(const pending_program& queued : pending){
+        if(queued.key == key){
+            return;
+        }
+    }
+    pending.push_back(pending_program{vertex_path, fragment_path, defines, key});
+}
+
+void shader_library::compile_pending(){
+    if(pending.empty()){
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if(GLEW_KHR_parallel_shader_compile){
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // as many threads as the driver likes
+    }
+    std::vector<program_build> builds;
+    for(const pending_program& queued : pending){
+        builds.push_back(begin_program_build(queued.vertex_path.c_str(), queued.fragment_path.c_str(), queued.defines));
+    }
+    std::vector<bool> finished(builds.size(), false);
+    size_t remaining = builds.size();
+    while(remaining > 0){
+        bool progressed = false;
+        for(size_t i = 0; i < builds.size(); i++){
+            if(finished[i] || !program_build_ready(builds[i])){
+                continue;
+            }
+            shared_program program = std::make_shared<shader_program>();
+            program->id = finish_program_build(builds[i]);
+            program->key = pending[i].key;
+            register_program(program);
+            preloaded.push_back(program);
+            finished[i] = true;
+            remaining--;
+            progressed = true;
+        }
+        if(!progressed){
+            std::this_thread::yield();
+        }
+    }
+    pending.clear();
+    creation_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void shader_library::register_program(const shared_program& program){
+    program->uniforms.build(program->id);
+    apply_block_bindings(program->id);
+    apply_sampler_bindings(*program);
+    programs[program->key] = program;
+    compile_count++;
+}
+
+void shader_library::set_block_binding(const std::string& block, GLuint binding){
+    block_bindings[block] = binding;
+    for(auto& entry : programs){
+        shared_program program = entry.second.lock();
+        if(program){
+            apply_block_bindings(program->id);
+        }
+    }
+}
+
+void shader_library::apply_block_bindings(GLuint program){
+    for(auto& binding : block_bindings){
+        GLuint index = glGetUniformBlockIndex(program, binding.first.c_str());
+        if(index != GL_INVALID_INDEX){
+            glUniformBlockBinding(program, index, binding.second);
+        }
+    }
+}
+
+void shader_library::set_sampler_binding(const std::string& sampler, int unit){
+    sampler_bindings[sampler] = unit;
+    for(auto& entry : programs){
+        shared_program program = entry.second.lock();
+        if(program){
+            apply_sampler_bindings(*program);
+        }
+    }
+}
+
+void shader_library::apply_sampler_bindings(shader_program& program){
+    gl_state().use_program(program.id);
+    for(auto& binding : sampler_bindings){
+        program.uniforms.set_1i(binding.first, binding.second);
+    }
+}
+
+int shader_library::live_programs(){
+    int live = 0;
+    for(auto it = programs.begin(); it != programs.end();){
+        if(it->second.expired()){
+            it = programs.erase(it);
+        }else{
+            live++;
+            it++;
+        }
+    }
+    return live;
+}
+
+int shader_library::compiled_programs() const{
+    return compile_count;
+}
+
+double shader_library::creation_time() const{
+    return creation_ms;
+}
+
+/**
+ * @brief Returns the program library shared by the whole application.
+ */
+shader_library& program_library(){
+    static shader_library library;
+    return library;
+}
+
+#endif
@@ -11,6 +11,19 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include "showcase3_functions.h"
+#include "headless.h"
+#include "frame_uniforms.h"
+#include "instance_batch.h"
+#include "showcase3_scene.h"
+#include "mesh_registry.h"
+#include "entity_store.h"
+#include "job_system.h"
+#include "fixed_timestep.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "gl_state_cache.h"
+#include "frame_profiler.h"
+#include "profiler_panel.h"
 #include "Camera.h"
 #include <cstdlib>
 
@@ -18,6 +31,7 @@ Camera camera(glm::vec3(20.0f, 10.0f, 20.0f));
 static bool first_mouse = true;
 bool cursor_enabled = false;
 static bool space_pressed = false;
+static bool click_pressed = false;
 static float lastX = (float)WINDOW_X / 2.0f;
 static float lastY = (float)WINDOW_Y / 2.0f;
 
@@ -36,6 +50,15 @@ void process_keyboard_input(GLFWwindow* window, float frame_time);
  */
 void process_mouse_input(GLFWwindow* window, double givenMousePositionX, double givenMousePositionY);
 
+/**
+ * @brief Removes the spawned object under the cursor on a left click, or the one under the screen center while the mouse
+ * looks around. Clicks on the ImGui windows are left to them.
+ * @param window The GLFW window.
+ * @param view The view matrix of this frame.
+ * @param projection The projection matrix of this frame.
+ */
+void process_picking(GLFWwindow* window, const glm::mat4& view, const glm::mat4& projection);
+
 /**
  * @brief Processes mouse scroll input.
  * @param givenWindow The GLFW window.
@@ -49,149 +72,6 @@ void process_scroll_input(GLFWwindow* givenWindow, double givenScrollOffsetX, do
  */
 void add_random_item();
 
-/**
- * @brief Moves a cube based on its position relative to the matrix floor.
- * @param model The model matrix of the cube.
- * @param position The position vector of the cube.
- * @param frame_time The time elapsed since the last frame.
- * @param matrix_position The position of the matrix floor center.
- * @param current_location The index of the cube in its respective vector.
- * @param option The type of object being moved (0: point light, 1: normal cube, 2: mixed cube, 3: normal map cube).
- */
-void move_cube(glm::mat4& model, glm::vec3& position, float frame_time, glm::vec3 matrix_position, int current_location, int option);
-
-GLfloat light_source_vertices[] =
-{
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-
-
-    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-    0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-    0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-    0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
-};
-
-float texture_cube_vertices[] = {
-    // positions          // normals           // texture coords
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-    0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-    0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-    0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-    0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-    0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
-    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-    0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
-};
-
-float normal_map_vertices[] = {
-    -0.500000f, -0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    0.500000f, -0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    0.500000f, 0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    0.500000f, 0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    -0.500000f, 0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    -0.500000f, -0.500000f, -0.500000f, 0.000000f, 0.000000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, -0.000000f, 1.000000f, -0.000000f,
-    -0.500000f, -0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    0.500000f, -0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    0.500000f, 0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    0.500000f, 0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    -0.500000f, 0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    -0.500000f, -0.500000f, 0.500000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f,
-    -0.500000f, 0.500000f, 0.500000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, 0.500000f, -0.500000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, -0.500000f, -1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, -0.500000f, -1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, 0.500000f, -1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, 0.500000f, 0.500000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    0.500000f, 0.500000f, 0.500000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    0.500000f, 0.500000f, -0.500000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, -0.500000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, -0.500000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, 0.500000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    0.500000f, 0.500000f, 0.500000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, -0.000000f, -0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, -0.500000f, 0.000000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, -0.500000f, 0.000000f, -1.000000f, 0.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, 0.500000f, 0.000000f, -1.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    0.500000f, -0.500000f, 0.500000f, 0.000000f, -1.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, 0.500000f, 0.000000f, -1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    -0.500000f, -0.500000f, -0.500000f, 0.000000f, -1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, -0.000000f, -1.000000f,
-    -0.500000f, 0.500000f, -0.500000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    0.500000f, 0.500000f, -0.500000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    0.500000f, 0.500000f, 0.500000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    0.500000f, 0.500000f, 0.500000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, 0.500000f, 0.500000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-    -0.500000f, 0.500000f, -0.500000f, 0.000000f, 1.000000f, 0.000000f, 0.000000f, 1.000000f, 1.000000f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, -1.000000f,
-};
-
-
-
 glm::vec3 directional_light_directions[] = {
     glm::vec3(0.0f, -0.5f, -1.0f),
     glm::vec3(-1.0f, -0.5f, 0.0f),
@@ -206,30 +86,35 @@ glm::vec3 directional_light_positions[] = {
     glm::vec3(10.0f, -5.0f, 10.0f)
 };
 
-std::vector<point_light_source> point_lights_vec;
 std::vector<directional_light_source> dir_lights_vec;
-std::vector<normal_textured_cube> normal_cube_vec;
-std::vector<mixed_textured_cube> mixed_cube_vec;
-std::vector<normal_map_cube> normal_map_cube_vec;
+//Every spawned light and cube, drawn by the instance batch of its material
+entity_store scene;
+//Per entity flag written by the parallel update pass, the removals are applied after it
+std::vector<unsigned char> reached_floor;
+//Per entity result of the culling pass
+std::vector<unsigned char> entity_visible;
+//Scratch of the point light reach query, it runs when asked for from ImGui
+std::vector<bounding_sphere> light_reach;
+std::vector<uint32_t> lit_ids;
+std::vector<int> lit_offsets;
+bool count_lit_requested = false;
+int lit_cubes = 0;
 
 float matrix_speed = 5.0f;
-float matrix_direction_x = 1.0f;
-float matrix_direction_z = 0.0f;
+matrix_floor_path matrix_path;
+//The scene moves in fixed steps, the frames are drawn between the last two of them
+fixed_timestep sim_clock;
+int sim_rate = 60;
 float cube_speed = 8.0f;
 float cube_direction = 5.0f;
 bool dir_lights_flag = true;
 bool dir_lights_flag_arr[] = {true, true, true, true};
 
-unsigned int container_texture;
-unsigned int container2_texture;
-unsigned int container2_specular_texture;
-unsigned int matrix_texture;
-unsigned int brickwall_texture;
-unsigned int brickwall_normal_texture;
-unsigned int awesome_face_texture;
+scene_textures textures;
 
-int main(){
-    GLFWwindow* window = initiate("Final Showcase");
+int main(int argc, char** argv){
+    run_options options = parse_run_options(argc, argv, WINDOW_X, WINDOW_Y);
+    GLFWwindow* window = options.headless ? initiate_headless("Final Showcase", options, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_CORE_PROFILE) : initiate("Final Showcase");
     glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
     stbi_set_flip_vertically_on_load(true);
@@ -237,13 +122,9 @@ int main(){
 	glfwSetScrollCallback(window, process_scroll_input);
     glfwSwapInterval(1); //VSYNC
 
-    container_texture = generate_texture("./res/Images/container.jpg");
-    container2_texture = generate_texture("./res/Images/container2.png");
-	container2_specular_texture = generate_texture("./res/Images/container2_specular.png");
-    matrix_texture = generate_texture("./res/Images/matrix.jpg");
-    brickwall_texture = generate_texture("./res/Images/brickwall.jpg");
-    brickwall_normal_texture = generate_texture("./res/Images/brickwall_normal.jpg");
-    awesome_face_texture = generate_texture("./res/Images/awesomeface.png");
+    //The material images stream through pixel buffers created here, not while the frames run
+    texture_library().prewarm(MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_SIZE, TEXTURE_UPLOAD_BUFFERS);
+    textures = load_scene_textures();
     //ImGUI Setup
     const char* glsl_version = "#version 330";
 	IMGUI_CHECKVERSION();
@@ -254,6 +135,21 @@ int main(){
 	ImGui::StyleColorsDark();
 	ImGui_ImplGlfw_InitForOpenGL(window, true);
 	ImGui_ImplOpenGL3_Init(glsl_version);
+    //Material samplers always read the same units, set once in every program instead of before every draw
+    register_material_samplers();
+    //Every compilation and link is issued before the first status is read
+    preload_scene_programs();
+    //Every spawned object of a type is drawn by its batch with a single instanced call
+    instance_batch entity_batches[ENTITY_TYPE_COUNT];
+    create_entity_batches(entity_batches, textures);
+    //Spawning and despawning reuse this memory instead of growing it
+    prewarm_entity_pools(scene, entity_batches, SPAWN_POOL_SIZE);
+    reached_floor.reserve(SPAWN_POOL_SIZE);
+    entity_visible.reserve(SPAWN_POOL_SIZE);
+
+    //Camera and light uniform blocks shared by every shader, filled once per frame
+    frame_uniforms frame_data;
+    frame_data.create();
     // For frame time calculations
     double frame_time = 0.0f;
     double current_frame = 0.0f;
@@ -265,55 +161,113 @@ int main(){
         directional_light_source dir_light(glm::vec3(0.25f), glm::vec3(0.25f), glm::vec3(0.25f), directional_light_directions[i]);
         dir_light.toggle_light(true);
         dir_light.set_position(directional_light_positions[i]);
-        dir_light.set_VAO(light_source_vertices, sizeof(light_source_vertices));
-        dir_light.set_program("./res/Shaders/VertexShader1_31.txt", "./res/Shaders/FragmentShader1_31.txt");
+        dir_light.set_mesh(scene_cube());
+        dir_light.set_program(LIGHT_MARKER_VERTEX_SHADER, LIGHT_MARKER_FRAGMENT_SHADER);
         dir_lights_vec.push_back(dir_light);
     }
     //Template on how to render a point light
     point_light_source demo_point_light(glm::vec3(0.25f), glm::vec3(0.25f), glm::vec3(0.25f), 1.0f, 0.045f, 0.0075f);
     demo_point_light.toggle_light(true);
     demo_point_light.set_position(glm::vec3(-25.0f, 15.0f, 0.0f));
-    demo_point_light.set_VAO(light_source_vertices, sizeof(light_source_vertices));
-    demo_point_light.set_program("./res/Shaders/VertexShader1_31.txt", "./res/Shaders/FragmentShader1_31.txt");
+    demo_point_light.set_mesh(scene_cube());
+    demo_point_light.set_program(LIGHT_MARKER_VERTEX_SHADER, LIGHT_MARKER_FRAGMENT_SHADER);
 
     //Template on how to render a normal texture cube
     normal_textured_cube demo_tex_cube;
     demo_tex_cube.set_position(glm::vec3(-20.0f, 15.0f, 0.0f));
-    demo_tex_cube.set_VAO(texture_cube_vertices, sizeof(texture_cube_vertices));
-    demo_tex_cube.set_program("./res/Shaders/VertexShader2_31.txt", "./res/Shaders/FragmentShader2_31.txt");
-    demo_tex_cube.assign_textures(container2_texture, container2_specular_texture);
+    demo_tex_cube.set_mesh(scene_cube());
+    demo_tex_cube.set_material(NORMAL_CUBE_MATERIAL);
+    demo_tex_cube.assign_textures(textures.array, textures.container2, textures.container2_specular);
 
     //Template on how to render a mixed texture cube
     mixed_textured_cube demo_mixed_cube;
     demo_mixed_cube.set_position(glm::vec3(-30.0f, 15.0f, 0.0f));
-    demo_mixed_cube.set_VAO(texture_cube_vertices, sizeof(texture_cube_vertices));
-    demo_mixed_cube.set_program("./res/Shaders/VertexShader3_31.txt", "./res/Shaders/FragmentShader3_31.txt");
-    demo_mixed_cube.assign_textures(container_texture, awesome_face_texture);
+    demo_mixed_cube.set_mesh(scene_cube());
+    demo_mixed_cube.set_material(MIXED_CUBE_MATERIAL);
+    demo_mixed_cube.assign_textures(textures.array, textures.container, textures.awesome_face);
 
     //Template on how to render a normal map cube
     normal_map_cube demo_normal_mapped_cube;
     demo_normal_mapped_cube.set_position(glm::vec3(-35.0f, 15.0f, 0.0f));
-    demo_normal_mapped_cube.set_normal_map_VAO(normal_map_vertices, sizeof(normal_map_vertices));
-    demo_normal_mapped_cube.set_program("./res/Shaders/VertexShader4_31.txt", "./res/Shaders/FragmentShader4_31.txt");
-    demo_normal_mapped_cube.assign_textures(brickwall_texture, brickwall_normal_texture);
+    demo_normal_mapped_cube.set_mesh(scene_cube());
+    demo_normal_mapped_cube.set_material(NORMAL_MAP_CUBE_MATERIAL);
+    demo_normal_mapped_cube.assign_textures(textures.array, textures.brickwall, textures.brickwall_normal);
 
     //Generating the container floor
     quad_object main_floor;
     main_floor.set_position(glm::vec3(-20.0f, 0.0f, 20.0f), glm::vec3(-20.0f, 0.0f, -20.0f), glm::vec3(20.0f, 0.0f, -20.0f), glm::vec3(20.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f));
-    main_floor.assign_textures(container2_texture, container2_specular_texture);
+    main_floor.assign_textures(textures.array, textures.container2, textures.container2_specular);
     main_floor.set_coordinates(glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f));
     main_floor.set_VAO();
-    main_floor.set_program("./res/Shaders/VertexShader4_31.txt", "./res/Shaders/FragmentShader4_31.txt");
+    main_floor.set_material(FLOOR_MATERIAL);
 
     //Generating the matrix floor
     simple_quad matrix_floor;
     matrix_floor.set_position(glm::vec3(-5.0f, 0.01f, 5.0f), glm::vec3(-5.0f, 0.01f, -5.0f), glm::vec3(5.0f, 0.01f, -5.0f), glm::vec3(5.0f, 0.01f, 5.0f), glm::vec3(0.0f, 0.01f, 0.0f));
-    matrix_floor.assign_textures(matrix_texture, matrix_texture);
+    matrix_floor.assign_textures(textures.array, textures.matrix, textures.matrix);
     matrix_floor.set_coordinates(glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f));
     matrix_floor.set_simple_VAO();
-    matrix_floor.set_program("./res/Shaders/VertexShader5_31.txt", "./res/Shaders/FragmentShader5_31.txt");
-
-    while(!glfwWindowShouldClose(window)){
+    matrix_floor.set_material(MATERIAL_UNLIT);
+
+    //Objects submitted and skipped by the culling pass, shown one frame late in the ImGui window
+    int visible_objects = 0;
+    int culled_objects = 0;
+    //Counts an object for the culling stats and tells if it has to be drawn
+    auto cull = [&](const frustum& view_frustum, const bounding_sphere& bounds){
+        bool visible = is_visible(view_frustum, bounds);
+        if(visible){
+            visible_objects++;
+        }else{
+            culled_objects++;
+        }
+        return visible;
+    };
+
+    //Draws are collected during the frame and issued sorted by state in one flush
+    render_queue queue;
+    //Profiler passes, each spawned entity type is charged to its own pass
+    int pass_update = profiler().add_pass("Scene update");
+    int pass_directional_lights = profiler().add_pass("Directional lights");
+    int pass_point_lights = profiler().add_pass("Point lights");
+    int entity_passes[ENTITY_TYPE_COUNT];
+    entity_passes[ENTITY_POINT_LIGHT] = pass_point_lights;
+    entity_passes[ENTITY_NORMAL_CUBE] = profiler().add_pass("Normal cubes");
+    entity_passes[ENTITY_MIXED_CUBE] = profiler().add_pass("Mixed cubes");
+    entity_passes[ENTITY_NORMAL_MAP_CUBE] = profiler().add_pass("Normal map cubes");
+    int pass_floors = profiler().add_pass("Floors");
+    int pass_demo_objects = profiler().add_pass("Demo objects");
+    int pass_imgui = profiler().add_pass("ImGui");
+    int pass_textures = profiler().add_pass("Texture streaming");
+
+    //Every kind of draw of the scene is issued once with the state of a frame, so the driver builds its shader variants
+    //now instead of stalling the frame that first shows an object
+    double warm_up_start = glfwGetTime();
+    queue.begin(100.0f);
+    for(instance_batch& batch : entity_batches){
+        batch.begin();
+        batch.add(glm::mat4(1.0f));
+        batch.submit(queue);
+    }
+    dir_lights_vec[0].submit(queue, camera.Position);
+    demo_point_light.submit(queue, camera.Position);
+    main_floor.submit(queue, camera.Position);
+    matrix_floor.submit_simple(queue, camera.Position);
+    demo_normal_mapped_cube.submit(queue, camera.Position);
+    demo_mixed_cube.submit(queue, camera.Position);
+    demo_tex_cube.submit(queue, camera.Position);
+    queue.warm_up();
+    //Later launches load most programs from the program binary cache
+    std::cout << "Shader programs: " << program_library().compiled_programs() << " created in " << program_library().creation_time()
+        << " ms, warmed up in " << (glfwGetTime() - warm_up_start) * 1000.0 << " ms, program binary cache: " << program_binaries().hits()
+        << " hits, " << program_binaries().misses() << " misses" << std::endl;
+    run_timer timer(options);
+    while(timer.keep_running(window)){
+        gl_state().begin_frame();
+        profiler().begin_frame();
+        //Moving a few chunks of the decoded images to their textures, the rest waits for the next frames
+        profiler().begin(pass_textures);
+        texture_library().update();
+        profiler().end();
         //Log frames to implement frame-based moving
         current_frame = glfwGetTime();
         frame_time = current_frame - last_frame;
@@ -323,6 +277,7 @@ int main(){
         glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
         process_keyboard_input(window, float(frame_time));
         //ImGui stuff
+        profiler().begin(pass_imgui);
         ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
@@ -336,90 +291,120 @@ int main(){
         }
         ImGui::SliderFloat("Cube speed", &cube_speed, 3.0f, 20.0f);
         ImGui::SliderFloat("Matrix speed", &matrix_speed, 3.0f, 20.0f);
+        if(ImGui::SliderInt("Simulation rate", &sim_rate, 10, 240)){
+            sim_clock.set_rate(double(sim_rate));
+        }
         ImGui::Text("FPS: %.2f, Frametime: %.3f", 1.0 / frame_time, frame_time);
+        ImGui::Text("Simulation: %lld steps, %.3f s dropped, interpolating at %.2f", sim_clock.steps(), sim_clock.dropped_time(), sim_clock.alpha());
+        ImGui::Text("Shader programs: %d live, %d compiled", program_library().live_programs(), program_library().compiled_programs());
+        ImGui::Text("Program binaries: %d hits, %d misses, %.1f ms creating programs", program_binaries().hits(), program_binaries().misses(),
+            program_library().creation_time());
+        ImGui::Text("Pixel buffers: %d created, %d reused", buffer_pool().created(), buffer_pool().reused());
+        ImGui::Text("Spawned: %d lights, %d cubes", scene.count(ENTITY_POINT_LIGHT), scene.size() - scene.count(ENTITY_POINT_LIGHT));
+        ImGui::Text("Culling: %d visible, %d culled", visible_objects, culled_objects);
+        ImGui::Text("Clustered lights: %d binned, %d cluster references", frame_data.clusters().light_count(), frame_data.clusters().light_references());
+        ImGui::Text("Spatial grid: %d entities in %d cells", scene.index().size(), scene.index().cell_count());
+        count_lit_requested = ImGui::Button("Count lit cubes");
+        ImGui::SameLine();
+        ImGui::Text("%d light and cube pairs", lit_cubes);
+        const gl_state_stats& gl_stats = gl_state().last_frame();
+        ImGui::Text("Draws: %d, program switches: %d of %d, VAO binds: %d of %d, texture binds: %d of %d", queue.size(),
+            gl_stats.program_switches, gl_stats.program_requests, gl_stats.vertex_array_binds, gl_stats.vertex_array_requests,
+            gl_stats.texture_binds, gl_stats.texture_requests);
 		ImGui::End();
+        draw_profiler_window(profiler());
+        profiler().end();
 
         //PROGRAM HERE
         glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WINDOW_X / (float)WINDOW_Y, 0.3f, 100.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)options.width / (float)options.height, 0.3f, 100.0f);
+        frame_data.update_camera(view, projection, camera.Position);
+        process_picking(window, view, projection);
+        queue.begin(100.0f);
+        //Only the objects whose bounds touch the view frustum are submitted
+        frustum view_frustum = extract_frustum(projection, view);
+        visible_objects = 0;
+        culled_objects = 0;
         //Rendering the directional lights
+        profiler().begin(pass_directional_lights);
         for(int i = 0; i < dir_lights_vec.size(); i++){
             if(dir_lights_flag && dir_lights_flag_arr[i]){
                 dir_lights_vec[i].enabled = true;
             }else{
                 dir_lights_vec[i].enabled = false;
             }
-            dir_lights_vec[i].render(view, projection);
-        }
-        //Rendering the point lights
-        for(int i = 0; i < point_lights_vec.size(); i++){
-            if(int(glfwGetTime()) % 2 == 0){
-                point_lights_vec[i].enabled = true;
-            }else{
-                point_lights_vec[i].enabled = false;
+            if(cull(view_frustum, dir_lights_vec[i].world_bounds())){
+                dir_lights_vec[i].submit(queue, camera.Position);
             }
-            point_lights_vec[i].render(view, projection);
-            move_cube(point_lights_vec[i].model, point_lights_vec[i].pos, float(frame_time), matrix_floor.center, i, 0);
-        }
-        //Rendering the normal cubes
-        for(int i = 0; i < normal_cube_vec.size(); i++){
-            normal_cube_vec[i].render(view, projection, camera.Position, dir_lights_vec, point_lights_vec);
-            move_cube(normal_cube_vec[i].model, normal_cube_vec[i].pos, float(frame_time), matrix_floor.center, i, 1);
         }
-        //Rendering the mixed cubes
-        for(int i = 0; i < mixed_cube_vec.size(); i++){
-            mixed_cube_vec[i].render(view, projection, camera.Position, 0.3f, dir_lights_vec, point_lights_vec);
-            move_cube(mixed_cube_vec[i].model, mixed_cube_vec[i].pos, float(frame_time), matrix_floor.center, i, 2);
+        //Running the simulation steps the time since the last frame holds, then placing the objects between the last two
+        profiler().begin(pass_update);
+        int steps = sim_clock.advance(options.fixed_frame_time > 0.0 ? options.fixed_frame_time : frame_time);
+        for(int step = steps; step > 0; step--){
+            double step_end = sim_clock.time() - (step - 1) * sim_clock.step_time();
+            step_entities(scene, reached_floor, sim_clock.step_time(), matrix_path.center, cube_speed, int(step_end) % 2 == 0);
+            matrix_path.step(sim_clock.step_time(), matrix_speed);
         }
-        //Rendering the normal mapped cubes
-        for(int i = 0; i < normal_map_cube_vec.size(); i++){
-            normal_map_cube_vec[i].render(view, projection, camera.Position, dir_lights_vec, point_lights_vec);
-            move_cube(normal_map_cube_vec[i].model, normal_map_cube_vec[i].pos, float(frame_time), matrix_floor.center, i, 3);
+        interpolate_entities(scene, sim_clock.alpha());
+        glm::vec3 matrix_offset = matrix_path.interpolated(sim_clock.alpha()) - matrix_floor.center;
+        matrix_floor.set_position(matrix_floor.pos1 + matrix_offset, matrix_floor.pos2 + matrix_offset, matrix_floor.pos3 + matrix_offset,
+            matrix_floor.pos4 + matrix_offset, matrix_floor.center + matrix_offset);
+        //Every light is final for this frame, upload them once for all lit objects
+        profiler().begin(pass_point_lights);
+        frame_data.update_lights(dir_lights_vec, scene);
+        if(count_lit_requested){
+            frame_data.point_light_reach(light_reach);
+            lit_cubes = count_lit_cubes(scene, light_reach, lit_ids, lit_offsets);
         }
+        //Rendering the visible spawned objects, one instanced draw per material
+        profiler().begin(pass_update);
+        int visible_entities = submit_entities(scene, view_frustum, entity_visible, entity_batches, queue, entity_passes);
+        visible_objects += visible_entities;
+        culled_objects += scene.size() - visible_entities;
         //Rendering the quads, first the main floor
-        main_floor.render(view, projection, camera.Position, dir_lights_vec, point_lights_vec);
-        //Rendering the matrix quad and its movement patern
-        matrix_floor.simple_render(view, projection);
-        matrix_floor.set_position(matrix_floor.pos1 + glm::vec3(frame_time*matrix_speed*matrix_direction_x, 0.0f, frame_time*matrix_speed*matrix_direction_z), 
-        matrix_floor.pos2 + glm::vec3(frame_time*matrix_speed*matrix_direction_x, 0.0f, frame_time*matrix_speed*matrix_direction_z), 
-        matrix_floor.pos3 + glm::vec3(frame_time*matrix_speed*matrix_direction_x, 0.0f, frame_time*matrix_speed*matrix_direction_z), 
-        matrix_floor.pos4 + glm::vec3(frame_time*matrix_speed*matrix_direction_x, 0.0f, frame_time*matrix_speed*matrix_direction_z),
-        matrix_floor.center + glm::vec3(frame_time*matrix_speed*matrix_direction_x, 0.0f, frame_time*matrix_speed*matrix_direction_z));
-
-        if(matrix_floor.center.x >= 17.5 && matrix_direction_x == 1.0f){
-            matrix_direction_z = 1.0f;
-            matrix_direction_x = 0.0f;
+        profiler().begin(pass_floors);
+        if(cull(view_frustum, main_floor.world_bounds())){
+            main_floor.submit(queue, camera.Position);
+        }
+        //Rendering the matrix quad
+        if(cull(view_frustum, matrix_floor.world_bounds())){
+            matrix_floor.submit_simple(queue, camera.Position);
         }
-        if(matrix_floor.center.z >= 17.5 && matrix_direction_z == 1.0f){
-            matrix_direction_z = 0.0f;
-            matrix_direction_x = -1.0f;
+        //Rendering the demo objects
+        profiler().begin(pass_demo_objects);
+        if(cull(view_frustum, demo_normal_mapped_cube.world_bounds())){
+            demo_normal_mapped_cube.submit(queue, camera.Position);
         }
-        if(matrix_floor.center.x <= -17.5 && matrix_direction_x == -1.0f){
-            matrix_direction_z = -1.0f;
-            matrix_direction_x = 0.0f;
+        if(cull(view_frustum, demo_mixed_cube.world_bounds())){
+            demo_mixed_cube.submit(queue, camera.Position);
         }
-        if(matrix_floor.center.z <= -17.5 && matrix_direction_z == -1.0f){
-            matrix_direction_z = 0.0f;
-            matrix_direction_x = 1.0f;
+        if(cull(view_frustum, demo_tex_cube.world_bounds())){
+            demo_tex_cube.submit(queue, camera.Position);
         }
-
-        //Rendering the demo objects
-        demo_normal_mapped_cube.render(view, projection, camera.Position, dir_lights_vec, point_lights_vec);
-        demo_mixed_cube.render(view, projection, camera.Position, 0.3f, dir_lights_vec, point_lights_vec);
-        demo_tex_cube.render(view, projection, camera.Position, dir_lights_vec, point_lights_vec);
-        if(int(glfwGetTime()) % 2 == 0){
+        if(int(sim_clock.time()) % 2 == 0){
             demo_point_light.enabled = true;
         }else{
             demo_point_light.enabled = false;
         }
-        demo_point_light.render(view, projection);
+        if(cull(view_frustum, demo_point_light.world_bounds())){
+            demo_point_light.submit(queue, camera.Position);
+        }
+        profiler().end();
 
+        //Issuing every draw of the frame sorted by pass, program, textures, mesh and depth
+        queue.flush();
         // Now render imgui
+        profiler().begin(pass_imgui);
         ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler().end_frame();
 
         glfwPollEvents();
-        glfwSwapBuffers(window);
+        timer.end_frame(window);
+    }
+    timer.report("Final Showcase");
+    if(options.headless){
+        terminate_headless();
     }
     terminate(window);
     return 0;
@@ -450,6 +435,30 @@ void process_keyboard_input(GLFWwindow* window, float frame_time){
     }
 }
 
+void process_picking(GLFWwindow* window, const glm::mat4& view, const glm::mat4& projection){
+    bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool clicked = pressed && !click_pressed && !ImGui::GetIO().WantCaptureMouse;
+    click_pressed = pressed;
+    if(!clicked){
+        return;
+    }
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    glm::vec2 cursor(float(width) / 2.0f, float(height) / 2.0f);
+    if(cursor_enabled){
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        cursor = glm::vec2(float(x), float(y));
+    }
+    glm::vec3 origin, direction;
+    screen_ray(view, projection, cursor, glm::vec2(float(width), float(height)), origin, direction);
+    int picked = pick_entity(scene, origin, direction, 100.0f);
+    if(picked >= 0){
+        scene.destroy(scene.handle_at(picked));
+        scene.flush_removals();
+    }
+}
+
 void process_mouse_input(GLFWwindow* window, double xpos, double ypos) {
 
     if (first_mouse) {
@@ -482,68 +491,18 @@ void process_scroll_input(GLFWwindow* givenWindow, double givenScrollOffsetX, do
 }
 
 void add_random_item(){
+    //Spawned objects only carry their components, their mesh, program and textures live in the instance batches
     int random_num = rand() % 4;
     int random_x = -15 + (rand() % 30);
     int random_z = -15 + (rand() % 30);
+    glm::vec3 position(float(random_x), 15.0f, float(random_z));
     if(random_num == 0){
-        point_light_source point_light(glm::vec3(0.25f), glm::vec3(0.25f), glm::vec3(0.25f), 1.0f, 0.045f, 0.0075f);
-        point_light.toggle_light(true);
-        point_light.set_position(glm::vec3(float(random_x), 15.0f, float(random_z)));
-        point_light.set_VAO(light_source_vertices, sizeof(light_source_vertices));
-        point_light.set_program("./res/Shaders/VertexShader1_31.txt", "./res/Shaders/FragmentShader1_31.txt");
-        point_lights_vec.push_back(point_light);
+        scene.create(ENTITY_POINT_LIGHT, position, ENTITY_POINT_LIGHT, scene_cube().bounds, spawned_point_light());
     }else if(random_num == 1){
-        normal_textured_cube tex_cube;
-        tex_cube.set_position(glm::vec3(float(random_x), 15.0f, float(random_z)));
-        tex_cube.set_VAO(texture_cube_vertices, sizeof(texture_cube_vertices));
-        tex_cube.set_program("./res/Shaders/VertexShader2_31.txt", "./res/Shaders/FragmentShader2_31.txt");
-        tex_cube.assign_textures(container2_texture, container2_specular_texture);
-        normal_cube_vec.push_back(tex_cube);
+        scene.create(ENTITY_NORMAL_CUBE, position, ENTITY_NORMAL_CUBE, scene_cube().bounds);
     }else if(random_num == 2){
-        mixed_textured_cube mixed_cube;
-        mixed_cube.set_position(glm::vec3(float(random_x), 15.0f, float(random_z)));
-        mixed_cube.set_VAO(texture_cube_vertices, sizeof(texture_cube_vertices));
-        mixed_cube.set_program("./res/Shaders/VertexShader3_31.txt", "./res/Shaders/FragmentShader3_31.txt");
-        mixed_cube.assign_textures(container_texture, awesome_face_texture);
-        mixed_cube_vec.push_back(mixed_cube);
+        scene.create(ENTITY_MIXED_CUBE, position, ENTITY_MIXED_CUBE, scene_cube().bounds);
     }else{
-        normal_map_cube normal_mapped_cube;
-        normal_mapped_cube.set_position(glm::vec3(float(random_x), 15.0f, float(random_z)));
-        normal_mapped_cube.set_normal_map_VAO(normal_map_vertices, sizeof(normal_map_vertices));
-        normal_mapped_cube.set_program("./res/Shaders/VertexShader4_31.txt", "./res/Shaders/FragmentShader4_31.txt");
-        normal_mapped_cube.assign_textures(brickwall_texture, brickwall_normal_texture);
-        normal_map_cube_vec.push_back(normal_mapped_cube);
+        scene.create(ENTITY_NORMAL_MAP_CUBE, position, ENTITY_NORMAL_MAP_CUBE, scene_cube().bounds);
     }
 }
-
-void move_cube(glm::mat4& model, glm::vec3& position, float frame_time, glm::vec3 matrix_position, int current_location, int option){
-    if(position.y > 0.01){
-        position = glm::vec3(position.x, position.y - frame_time * cube_speed, position.z);
-        model = glm::translate(glm::mat4(1.0f), glm::vec3(position));
-    }else{
-        float x_dir, z_dir;
-        if(matrix_position.x > position.x){
-            x_dir = 1.0f;
-        }else{
-            x_dir = -1.0f;
-        }
-        if(matrix_position.z > position.z){
-            z_dir = 1.0f;
-        }else{
-            z_dir = -1.0f;
-        }
-        position = glm::vec3(position.x + cube_speed * frame_time * x_dir, position.y, position.z + cube_speed * frame_time * z_dir);
-        model = glm::translate(glm::mat4(1.0f), glm::vec3(position));
-        if(abs(position.x - matrix_position.x) < 0.5f && abs(position.z - matrix_position.z) < 0.5f){
-            if(option == 0){
-                point_lights_vec.erase(point_lights_vec.begin() + current_location);
-            }else if(option == 1){
-                normal_cube_vec.erase(normal_cube_vec.begin() + current_location);
-            }else if(option == 2){
-                mixed_cube_vec.erase(mixed_cube_vec.begin() + current_location);
-            }else{
-                normal_map_cube_vec.erase(normal_map_cube_vec.begin() + current_location);
-            }
-        }
-    }
-}
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "showcase3_functions.h"
+#include "headless.h"
+#include "frame_uniforms.h"
+#include "instance_batch.h"
+#include "showcase3_scene.h"
+#include "entity_store.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "gl_state_cache.h"
+
+// Spawned objects are spread over the main floor area and up to the spawn height of add_random_item()
+const float BENCH_HALF_EXTENT = 20.0f;
+const float BENCH_MAX_HEIGHT = 15.0f;
+const unsigned int BENCH_SEED = 1234;
+const float BENCH_CAMERA_RADIUS = 35.0f;
+
+/**
+ * @brief What the benchmark sweeps and where it writes the results.
+ */
+struct bench_options{
+    std::vector<int> object_counts = {10, 100, 1000, 10000, 100000};
+    std::vector<int> light_counts = {1, 4, 16, 64, 256};
+    int warmup_frames = 10;
+    int frames = 120;
+    run_options run;
+    std::string output = "showcase3_bench.csv";
+};
+
+/**
+ * @brief Parses a comma separated list of positive counts.
+ * @param text The list, e.g. "10,100,1000".
+ * @param counts Receives the counts.
+ * @return False if an entry is not a positive number.
+ */
+bool parse_counts(const std::string& text, std::vector<int>& counts){
+    counts.clear();
+    std::stringstream stream(text);
+    std::string entry;
+    while(std::getline(stream, entry, ',')){
+        int count = atoi(entry.c_str());
+        if(count <= 0){
+            return false;
+        }
+        counts.push_back(count);
+    }
+    return !counts.empty();
+}
+
+/**
+ * @brief Parses the benchmark command line, unknown arguments end the program with the usage.
+ */
+bench_options parse_bench_options(int argc, char** argv){
+    bench_options options;
+    options.run.headless = true;
+    options.run.width = WINDOW_X;
+    options.run.height = WINDOW_Y;
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if(argument == "--objects" && has_value && parse_counts(argv[i + 1], options.object_counts)){
+            i++;
+        }else if(argument == "--lights" && has_value && parse_counts(argv[i + 1], options.light_counts)){
+            i++;
+        }else if(argument == "--frames" && has_value && (options.frames = atoi(argv[i + 1])) > 0){
+            i++;
+        }else if(argument == "--warmup" && has_value && (options.warmup_frames = atoi(argv[i + 1])) >= 0){
+            i++;
+        }else if(argument == "--size" && has_value && sscanf(argv[i + 1], "%dx%d", &options.run.width, &options.run.height) == 2
+            && options.run.width > 0 && options.run.height > 0){
+            i++;
+        }else if(argument == "--output" && has_value){
+            options.output = argv[++i];
+        }else{
+            std::cout << "Usage: " << argv[0] << " [--objects 10,100,...] [--lights 1,4,...] [--frames N] [--warmup N]"
+                " [--size WIDTHxHEIGHT] [--output file.csv]\n";
+            exit(1);
+        }
+    }
+    return options;
+}
+
+/**
+ * @brief Fills the scene with a fixed layout: the same counts always give the same objects and lights.
+ * Cubes cycle through the three cube materials, lights use the parameters of spawned lights.
+ * @param scene The store to fill, cleared first.
+ * @param object_count The number of cubes.
+ * @param light_count The number of point lights.
+ */
+void build_bench_scene(entity_store& scene, int object_count, int light_count){
+    scene.clear();
+    std::uniform_real_distribution<float> horizontal(-BENCH_HALF_EXTENT, BENCH_HALF_EXTENT);
+    std::uniform_real_distribution<float> vertical(0.5f, BENCH_MAX_HEIGHT);
+    // Separate generators, so the cube layout does not change with the light count
+    std::mt19937 object_random(BENCH_SEED);
+    for(int i = 0; i < object_count; i++){
+        entity_type type = entity_type(ENTITY_NORMAL_CUBE + i % 3);
+        glm::vec3 position(horizontal(object_random), vertical(object_random), horizontal(object_random));
+        scene.create(type, position, type, scene_cube().bounds);
+    }
+    std::mt19937 light_random(BENCH_SEED + 1);
+    for(int i = 0; i < light_count; i++){
+        glm::vec3 position(horizontal(light_random), vertical(light_random), horizontal(light_random));
+        scene.create(ENTITY_POINT_LIGHT, position, ENTITY_POINT_LIGHT, scene_cube().bounds, spawned_point_light());
+    }
+}
+
+/**
+ * @brief Returns the view matrix of the camera path, one orbit around the scene that also rises and sinks.
+ * @param progress The position on the path, from 0 to 1.
+ * @param camera_position Receives the position of the camera.
+ */
+glm::mat4 bench_camera_view(float progress, glm::vec3& camera_position){
+    float angle = progress * 2.0f * 3.14159265f;
+    camera_position = glm::vec3(BENCH_CAMERA_RADIUS * cos(angle), 12.0f + 6.0f * sin(2.0f * angle), BENCH_CAMERA_RADIUS * sin(angle));
+    return glm::lookAt(camera_position, glm::vec3(0.0f, 4.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+/**
+ * @brief Counters of one measured frame.
+ */
+struct bench_frame{
+    double cpu_ms; // until every draw was issued
+    double frame_ms; // until the GPU finished
+    int draw_calls;
+    long long uniform_uploads;
+    int program_switches;
+    int visible_objects;
+    int cluster_references;
+};
+
+/**
+ * @brief Returns the mean of one field over the frames.
+ */
+template<typename T>
+double frame_mean(const std::vector<bench_frame>& frames, T bench_frame::* field){
+    double sum = 0.0;
+    for(const bench_frame& frame : frames){
+        sum += double(frame.*field);
+    }
+    return sum / double(frames.size());
+}
+
+int main(int argc, char** argv){
+    bench_options options = parse_bench_options(argc, argv);
+    FILE* csv = fopen(options.output.c_str(), "w");
+    if(csv == NULL){
+        std::cout << "Could not open " << options.output << " for writing! Terminating...\n";
+        return 1;
+    }
+    GLFWwindow* window = initiate_headless("Showcase3 Bench", options.run, OPENGL_TARGET_MAJOR, OPENGL_TARGET_MINOR, GLFW_OPENGL_CORE_PROFILE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+
+    scene_textures textures = load_scene_textures();
+    // Every configuration is measured with the final textures
+    texture_library().finish();
+    register_material_samplers();
+    instance_batch entity_batches[ENTITY_TYPE_COUNT];
+    create_entity_batches(entity_batches, textures);
+    frame_uniforms frame_data;
+    frame_data.create();
+
+    // The directional lights of the showcase, only their light is used
+    const glm::vec3 directions[] = {glm::vec3(0.0f, -0.5f, -1.0f), glm::vec3(-1.0f, -0.5f, 0.0f), glm::vec3(0.0f, -0.5f, 1.0f), glm::vec3(1.0f, -0.5f, 1.0f)};
+    std::vector<directional_light_source> dir_lights;
+    for(const glm::vec3& direction : directions){
+        directional_light_source dir_light(glm::vec3(0.25f), glm::vec3(0.25f), glm::vec3(0.25f), direction);
+        dir_light.toggle_light(true);
+        dir_lights.push_back(dir_light);
+    }
+    quad_object main_floor;
+    main_floor.set_position(glm::vec3(-20.0f, 0.0f, 20.0f), glm::vec3(-20.0f, 0.0f, -20.0f), glm::vec3(20.0f, 0.0f, -20.0f), glm::vec3(20.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+    main_floor.assign_textures(textures.array, textures.container2, textures.container2_specular);
+    main_floor.set_coordinates(glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f));
+    main_floor.set_VAO();
+    main_floor.set_material(FLOOR_MATERIAL);
+
+    entity_store scene;
+    std::vector<unsigned char> visible;
+    render_queue queue;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)options.run.width / (float)options.run.height, 0.3f, 100.0f);
+    std::vector<bench_frame> frames;
+
+    fprintf(csv, "objects,point_lights,frames,cpu_mean_ms,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,frame_mean_ms,frame_p99_ms,"
+        "draw_calls,uniform_uploads,program_switches,visible_objects,cluster_references\n");
+    for(int object_count : options.object_counts){
+        for(int light_count : options.light_counts){
+            build_bench_scene(scene, object_count, light_count);
+            frames.clear();
+            for(int frame = 0; frame < options.warmup_frames + options.frames; frame++){
+                bool measured = frame >= options.warmup_frames;
+                float progress = measured ? float(frame - options.warmup_frames) / float(options.frames) : 0.0f;
+                auto frame_start = std::chrono::steady_clock::now();
+                long long uploads_before = uniform_upload_stats.uploads;
+                gl_state().begin_frame();
+                glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                glm::vec3 camera_position;
+                glm::mat4 view = bench_camera_view(progress, camera_position);
+                frame_data.update_camera(view, projection, camera_position);
+                queue.begin(100.0f);
+                frustum view_frustum = extract_frustum(projection, view);
+                frame_data.update_lights(dir_lights, scene);
+                int visible_objects = submit_entities(scene, view_frustum, visible, entity_batches, queue);
+                if(is_visible(view_frustum, main_floor.world_bounds())){
+                    main_floor.submit(queue, camera_position);
+                }
+                queue.flush();
+                auto cpu_end = std::chrono::steady_clock::now();
+                glFinish();
+                auto frame_end = std::chrono::steady_clock::now();
+                // Moves this frame's bind counters to last_frame()
+                gl_state().begin_frame();
+
+                if(measured){
+                    bench_frame result;
+                    result.cpu_ms = std::chrono::duration<double, std::milli>(cpu_end - frame_start).count();
+                    result.frame_ms = std::chrono::duration<double, std::milli>(frame_end - frame_start).count();
+                    result.draw_calls = queue.size();
+                    result.uniform_uploads = uniform_upload_stats.uploads - uploads_before;
+                    result.program_switches = gl_state().last_frame().program_switches;
+                    result.visible_objects = visible_objects;
+                    result.cluster_references = frame_data.clusters().light_references();
+                    frames.push_back(result);
+                }
+            }
+
+            std::vector<double> cpu_times;
+            std::vector<double> frame_times;
+            for(const bench_frame& frame : frames){
+                cpu_times.push_back(frame.cpu_ms);
+                frame_times.push_back(frame.frame_ms);
+            }
+            std::sort(cpu_times.begin(), cpu_times.end());
+            std::sort(frame_times.begin(), frame_times.end());
+            fprintf(csv, "%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%.1f,%.1f,%.1f,%.1f\n", object_count, light_count, int(frames.size()),
+                frame_mean(frames, &bench_frame::cpu_ms), sorted_percentile(cpu_times, 0.5), sorted_percentile(cpu_times, 0.95),
+                sorted_percentile(cpu_times, 0.99), frame_mean(frames, &bench_frame::frame_ms), sorted_percentile(frame_times, 0.99),
+                frame_mean(frames, &bench_frame::draw_calls), frame_mean(frames, &bench_frame::uniform_uploads),
+                frame_mean(frames, &bench_frame::program_switches), frame_mean(frames, &bench_frame::visible_objects),
+                frame_mean(frames, &bench_frame::cluster_references));
+            fflush(csv);
+            printf("%d objects, %d lights: cpu %.3f ms, frame %.3f ms\n", object_count, light_count,
+                frame_mean(frames, &bench_frame::cpu_ms), frame_mean(frames, &bench_frame::frame_ms));
+        }
+    }
+    fclose(csv);
+    std::cout << "Results written to " << options.output << "\n";
+
+    terminate_headless();
+    terminate(window);
+    return 0;
+}
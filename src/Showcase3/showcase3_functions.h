@@ -1,3 +1,6 @@
+#ifndef SHOWCASE3_FUNCTIONS_H
+#define SHOWCASE3_FUNCTIONS_H
+
 #include <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -8,6 +11,12 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include "shader_library.h"
+#include "mesh_registry.h"
+#include "bounding_volume.h"
+#include "render_queue.h"
+#include "texture_array.h"
+#include "material_shader.h"
 
 const int OPENGL_TARGET_MAJOR = 3;
 const int OPENGL_TARGET_MINOR = 3;
@@ -63,266 +72,38 @@ GLFWwindow* initiate(const std::string WINDOW_NAME){
  * @param window The window to destroy.
  */
 void terminate(GLFWwindow* window){
+    shader_context_alive = false;
     glfwDestroyWindow(window);
     glfwTerminate();
 }
 
 /**
- * @brief Reads a shader file from the given path.
- * @param path The path to the shader file.
- * @return The content of the shader file as a string.
- */
-std::string read_shader(const char* path){
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        std::cerr << "Error: Shader file '" << path << "' not found or failed to open!\n";
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    if (buffer.str().empty()) {
-        std::cerr << "Error: Shader file '" << path << "' is empty!" << std::endl;
-    }
-
-    return buffer.str();
-}
-
-/**
- * @brief Compiles a shader from source code.
- * @param type The type of shader (e.g., GL_VERTEX_SHADER, GL_FRAGMENT_SHADER).
- * @param source The source code of the shader.
- * @return The ID of the compiled shader.
- */
-GLuint compile_shader(GLenum type, const char* source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cout << "Shader compilation failed:\n" << infoLog << "\n";
-    }
-
-    return shader;
-}
-
-/**
- * @brief Creates a shader program from vertex and fragment shader paths.
- * @param vertex_path Path to the vertex shader file.
- * @param fragment_path Path to the fragment shader file.
- * @return The ID of the created shader program.
- */
-GLuint create_shader_program(const char* vertex_path, const char* fragment_path) {
-    std::string s1 = read_shader(vertex_path);
-    std::string s2 = read_shader(fragment_path);
-    const char* vertex_code = s1.c_str();
-    const char* fragment_code = s2.c_str();
-
-    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_code);
-    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_code);
-
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
-
-    int success;
-    char infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cout << "Shader linking failed:\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-
-    return program;
-}
-
-/**
- * @brief Sets an integer uniform in the shader program.
- * @param program The shader program ID.
- * @param name The name of the uniform.
- * @param value The integer value to set.
- */
-void program_set_1i(GLuint &program, std::string name, int value){
-    GLuint location = glGetUniformLocation(program, name.c_str());
-    glUniform1i(location, value);
-}
-
-/**
- * @brief Sets a float uniform in the shader program.
- * @param program The shader program ID.
- * @param name The name of the uniform.
- * @param value The float value to set.
- */
-void program_set_1f(GLuint &program, std::string name, float value){
-    GLuint location = glGetUniformLocation(program, name.c_str());
-    glUniform1f(location, value);
-}
-
-/**
- * @brief Sets a vec3 uniform in the shader program.
- * @param program The shader program ID.
- * @param name The name of the uniform.
- * @param value1 The first component of the vector.
- * @param value2 The second component of the vector.
- * @param value3 The third component of the vector.
- */
-void program_set_3f(GLuint &program, std::string name, float value1, float value2, float value3){
-    GLuint location = glGetUniformLocation(program, name.c_str());
-    glUniform3f(location, value1, value2, value3);
-
-}
-
-/**
- * @brief Sets a mat3 uniform in the shader program.
- * @param program The shader program ID.
- * @param name The name of the uniform.
- * @param value The mat3 value to set.
- */
-void program_set_M3fv(GLuint &program, std::string name, glm::mat3 value){
-    GLuint location = glGetUniformLocation(program, name.c_str());
-    glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
-}
-
-/**
- * @brief Sets a mat4 uniform in the shader program.
- * @param program The shader program ID.
- * @param name The name of the uniform.
- * @param value The mat4 value to set.
- */
-void program_set_M4fv(GLuint &program, std::string name, glm::mat4 value){
-    GLuint location = glGetUniformLocation(program, name.c_str());
-    glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
-}
-
-/**
- * @brief Generates a texture from an image file.
- * @param givenTextureFilePath Path to the image file.
- * @return The ID of the generated texture.
+ * @brief Computes the tangent and bitangent of a triangle from its positions and texture coordinates.
+ * @param pos1 The first corner, the edges start from it.
+ * @param pos2 The second corner.
+ * @param pos3 The third corner.
+ * @param uv1 The texture coordinates of the first corner.
+ * @param uv2 The texture coordinates of the second corner.
+ * @param uv3 The texture coordinates of the third corner.
+ * @param tangent Receives the tangent.
+ * @param bitangent Receives the bitangent.
  */
-unsigned int generate_texture(const char* givenTextureFilePath)
-{
-	unsigned int textureId;
-	glGenTextures(1, &textureId);
-
-	stbi_set_flip_vertically_on_load(true);
-
-	int imageWidth, imageHeight, numberOfchannels;
-	unsigned char* imageData;
-	imageData = stbi_load(givenTextureFilePath, &imageWidth, &imageHeight, &numberOfchannels, 0);
-
-	int imageFormat = 3;
-
-	if (numberOfchannels == 1)
-		imageFormat = GL_RED;
-	else if (numberOfchannels == 3)
-		imageFormat = GL_RGB;
-	else if (numberOfchannels == 4)
-		imageFormat = GL_RGBA;
-
-	if (imageData)
-	{
-		glBindTexture(GL_TEXTURE_2D, textureId);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, imageFormat, imageWidth, imageHeight, 0, imageFormat, GL_UNSIGNED_BYTE, imageData);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-	else
-		std::cout << "Could not read the image!!!" << std::endl;
-
-	stbi_image_free(imageData);
-	return textureId;
-}
-
-/**
- * @brief Calculates tangents and bitangents for a cube mesh.
- * @param verts Pointer to the vertex data.
- * @param vertexCount The number of vertices.
- * @return Pointer to the calculated tangent and bitangent data.
- */
-float* calculate_cube_tangents(const float* verts, size_t vertexCount)
-{
-    // Allocate accumulators
-    glm::vec3* tanAccum = new glm::vec3[vertexCount]();
-    glm::vec3* bitanAccum = new glm::vec3[vertexCount]();
-
-    // Iterate triangles
-    for (size_t i = 0; i + 2 < vertexCount; i += 3)
-    {
-        const float* v0 = verts + (i + 0) * 8;
-        const float* v1 = verts + (i + 1) * 8;
-        const float* v2 = verts + (i + 2) * 8;
-
-        glm::vec3 p0(v0[0], v0[1], v0[2]);
-        glm::vec3 p1(v1[0], v1[1], v1[2]);
-        glm::vec3 p2(v2[0], v2[1], v2[2]);
-
-        glm::vec2 uv0(v0[6], v0[7]);
-        glm::vec2 uv1(v1[6], v1[7]);
-        glm::vec2 uv2(v2[6], v2[7]);
-
-        glm::vec3 dPos1 = p1 - p0;
-        glm::vec3 dPos2 = p2 - p0;
-        glm::vec2 dUV1  = uv1 - uv0;
-        glm::vec2 dUV2  = uv2 - uv0;
-
-        float denom = dUV1.x * dUV2.y - dUV2.x * dUV1.y;
-        float r = denom != 0.0f ? 1.0f / denom : 0.0f;
-
-        glm::vec3 tangent  = (dPos1 * dUV2.y - dPos2 * dUV1.y) * r;
-        glm::vec3 bitangent = (dPos2 * dUV1.x - dPos1 * dUV2.x) * r;
-
-        // accumulate for each triangle corner
-        for (int j = 0; j < 3; ++j) {
-            tanAccum[i + j]    += tangent;
-            bitanAccum[i + j]  += bitangent;
-        }
-    }
-
-    // Output array: [Tx,Ty,Tz, Bx,By,Bz] * vertexCount
-    float* out = new float[vertexCount * 6];
-
-    // Orthonormalize and compute final bitangent handedness
-    for (size_t i = 0; i < vertexCount; ++i)
-    {
-        const float* v = verts + i * 8;
-        glm::vec3 n(v[3], v[4], v[5]);
-
-        // Gram�Schmidt tangent
-        glm::vec3 t = tanAccum[i];
-        t = glm::normalize(t - n * glm::dot(n, t));
+void triangle_tangents(const glm::vec3& pos1, const glm::vec3& pos2, const glm::vec3& pos3, const glm::vec2& uv1, const glm::vec2& uv2, const glm::vec2& uv3,
+    glm::vec3& tangent, glm::vec3& bitangent){
+    glm::vec3 edge1 = pos2 - pos1;
+    glm::vec3 edge2 = pos3 - pos1;
+    glm::vec2 deltaUV1 = uv2 - uv1;
+    glm::vec2 deltaUV2 = uv3 - uv1;
 
-        // Gram�Schmidt bitangent (optional, but we'll recompute handed bitangent)
-        glm::vec3 b = bitanAccum[i];
-        // Compute handedness
-        float w = (glm::dot(glm::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
-        // Final bitangent orthogonal to n and t
-        glm::vec3 finalB = glm::cross(n, t) * w;
+    float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
 
-        out[i*6 + 0] = t.x;
-        out[i*6 + 1] = t.y;
-        out[i*6 + 2] = t.z;
-        out[i*6 + 3] = finalB.x;
-        out[i*6 + 4] = finalB.y;
-        out[i*6 + 5] = finalB.z;
-    }
+    tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
+    tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
+    tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
 
-    delete[] tanAccum;
-    delete[] bitanAccum;
-    return out;
+    bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
+    bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
+    bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
 }
 
 /**
@@ -335,7 +116,9 @@ public:
     glm::vec3 diffuse;
     glm::vec3 specular;
     GLuint VAO;
+    const gpu_mesh* mesh = nullptr;
     GLuint program;
+    shared_program shader;
     glm::mat4 model;
     glm::vec3 pos;
     /**
@@ -344,61 +127,68 @@ public:
      */
     void toggle_light(bool status);
     /**
-     * @brief Sets the Vertex Array Object (VAO) for the light source.
-     * @param vertices Pointer to the vertex data.
-     * @param size Size of the vertex data in bytes.
+     * @brief Sets the shared mesh the light source is drawn with.
+     * @param shared_mesh The mesh from the mesh registry.
      */
-    void set_VAO(float* vertices, int size);
+    void set_mesh(const gpu_mesh& shared_mesh);
     /**
-     * @brief Sets the shader program for the light source.
+     * @brief Sets the shader program for the light source, sharing it with every other user of the same shaders.
      * @param vertex_path Path to the vertex shader.
      * @param fragment_path Path to the fragment shader.
      */
     void set_program(std::string vertex_path, std::string fragment_path);
     /**
-     * @brief Renders the light source.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
+     * @brief Queues the light source marker. The camera comes from the camera_data uniform block.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void render(glm::mat4 view, glm::mat4 projection);
+    void submit(render_queue& queue, const glm::vec3& camera_position);
+    /**
+     * @brief Returns the world space bounding sphere of the light marker.
+     */
+    bounding_sphere world_bounds() const;
 private:
+    static void issue_draw(void* object);
 };
 
 void light_source::toggle_light(bool status){
     enabled = status;
 }
 
-void light_source::set_VAO(float* vertices, int size){
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void light_source::set_mesh(const gpu_mesh& shared_mesh){
+    mesh = &shared_mesh;
+    VAO = shared_mesh.VAO;
 }
 
 void light_source::set_program(std::string vertex_path, std::string fragment_path){
-    program = create_shader_program(vertex_path.c_str(), fragment_path.c_str());
-}
-
-void light_source::render(glm::mat4 view, glm::mat4 projection){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    if(enabled){
-        program_set_1i(program, "active_light", 1);
+    shader = program_library().acquire(vertex_path, fragment_path);
+    program = shader->id;
+}
+
+void light_source::submit(render_queue& queue, const glm::vec3& camera_position){
+    draw_item item;
+    item.program = program;
+    item.VAO = VAO;
+    item.depth = glm::distance(camera_position, pos);
+    item.issue = &light_source::issue_draw;
+    item.object = this;
+    queue.submit(item);
+}
+
+void light_source::issue_draw(void* object){
+    light_source& light = *static_cast<light_source*>(object);
+    uniform_table& uniforms = light.shader->uniforms;
+    uniforms.set_M4fv("model", light.model);
+    if(light.enabled){
+        uniforms.set_1i("active_light", 1);
     }else{
-        program_set_1i(program, "active_light", 0);
+        uniforms.set_1i("active_light", 0);
     }
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glUseProgram(0);
-    glBindVertexArray(0);
+    light.mesh->draw();
+}
+
+bounding_sphere light_source::world_bounds() const{
+    return transform_bounds(mesh->bounds, model);
 }
 
 /**
@@ -423,7 +213,6 @@ directional_light_source::directional_light_source(glm::vec3 ambient_val, glm::v
     diffuse = diffuse_val;
     specular = specular_val;
     direction = direction_val;
-    glGenVertexArrays(1, &VAO);
 }
 
 void directional_light_source::set_position(glm::vec3 new_position){
@@ -457,7 +246,6 @@ point_light_source::point_light_source(glm::vec3 ambient_val, glm::vec3 diffuse_
     constant = constant_val;
     linear = linear_val;
     quadratic = quadratic_val;
-    glGenVertexArrays(1, &VAO);
 }
 
 void point_light_source::set_position(glm::vec3 new_position){
@@ -471,11 +259,13 @@ void point_light_source::set_position(glm::vec3 new_position){
 class textured_cube{
 public:
     GLuint VAO;
+    const gpu_mesh* mesh = nullptr;
     GLuint program;
+    shared_program shader;
     glm::mat4 model;
     glm::vec3 pos;
-    unsigned int texture1;
-    unsigned int texture2;
+    GLuint texture_array_id = 0;
+    glm::vec2 texture_layers = glm::vec2(0.0f); // the layers of the first and second texture
     textured_cube(){};
     /**
      * @brief Sets the position of the cube.
@@ -483,24 +273,34 @@ public:
      */
     void set_position(glm::vec3 new_position);
     /**
-     * @brief Sets the Vertex Array Object (VAO) for the cube.
-     * @param vertices Pointer to the vertex data.
-     * @param size Size of the vertex data in bytes.
+     * @brief Sets the shared mesh the cube is drawn with.
+     * @param shared_mesh The mesh from the mesh registry.
      */
-    void set_VAO(float* vertices, int size);
+    void set_mesh(const gpu_mesh& shared_mesh);
     /**
-     * @brief Sets the shader program for the cube.
-     * @param vertex_path Path to the vertex shader.
-     * @param fragment_path Path to the fragment shader.
+     * @brief Sets the material uber shader permutation of the cube, sharing it with every other user of the same features.
+     * @param features The material_feature flags.
      */
-    void set_program(std::string vertex_path, std::string fragment_path);
+    void set_material(unsigned features);
     /**
-     * @brief Assigns textures to the cube.
-     * @param tex1 ID of the first texture.
-     * @param tex2 ID of the second texture.
+     * @brief Assigns the texture array and the layers of the cube's textures.
+     * @param array The texture array.
+     * @param layer1 Layer of the first texture.
+     * @param layer2 Layer of the second texture.
      */
-    void assign_textures(unsigned int tex1, unsigned int tex2);
-private:
+    void assign_textures(const texture_array& array, int layer1, int layer2);
+    /**
+     * @brief Returns the world space bounding sphere of the cube.
+     */
+    bounding_sphere world_bounds() const;
+protected:
+    /**
+     * @brief Queues the cube with its program, mesh and textures.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
+     * @param issue Sets the per-object uniforms and draws, called with this cube once its state is bound.
+     */
+    void submit_cube(render_queue& queue, const glm::vec3& camera_position, void (*issue)(void* object));
 };
 
 void textured_cube::set_position(glm::vec3 new_position){
@@ -508,32 +308,35 @@ void textured_cube::set_position(glm::vec3 new_position){
     pos = new_position;
 }
 
-void textured_cube::set_VAO(float* vertices, int size){
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+void textured_cube::set_mesh(const gpu_mesh& shared_mesh){
+    mesh = &shared_mesh;
+    VAO = shared_mesh.VAO;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+void textured_cube::set_material(unsigned features){
+    shader = program_library().acquire(MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(features));
+    program = shader->id;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void textured_cube::assign_textures(const texture_array& array, int layer1, int layer2){
+    texture_array_id = array.id();
+    texture_layers = glm::vec2(float(layer1), float(layer2));
 }
 
-void textured_cube::set_program(std::string vertex_path, std::string fragment_path){
-    program = create_shader_program(vertex_path.c_str(), fragment_path.c_str());
+bounding_sphere textured_cube::world_bounds() const{
+    return transform_bounds(mesh->bounds, model);
 }
 
-void textured_cube::assign_textures(unsigned int tex1, unsigned int tex2){
-    texture1 = tex1;
-    texture2 = tex2;
+void textured_cube::submit_cube(render_queue& queue, const glm::vec3& camera_position, void (*issue)(void* object)){
+    draw_item item;
+    item.program = program;
+    item.VAO = VAO;
+    item.texture1 = texture_array_id;
+    item.texture_target = GL_TEXTURE_2D_ARRAY;
+    item.depth = glm::distance(camera_position, pos);
+    item.issue = issue;
+    item.object = this;
+    queue.submit(item);
 }
 
 /**
@@ -542,79 +345,28 @@ void textured_cube::assign_textures(unsigned int tex1, unsigned int tex2){
 class normal_textured_cube : public textured_cube{
 public:
     /**
-     * @brief Renders the cube.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
-     * @param camera_position The position of the camera.
-     * @param dir_sources Vector of directional light sources.
-     * @param point_sources Vector of point light sources.
+     * @brief Queues the cube. Camera and lights come from the camera_data and light_data uniform blocks.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources);
+    void submit(render_queue& queue, const glm::vec3& camera_position);
+private:
+    static void issue_draw(void* object);
 };
 
-void normal_textured_cube::render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(model)));
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    program_set_M3fv(program, "normal", normal_transformation);
-    program_set_3f(program, "camera_position", camera_position.x, camera_position.y, camera_position.z);
-    program_set_1i(program, "dir_lights", int(dir_sources.size()));
-    program_set_1i(program, "point_lights", int(point_sources.size()));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    program_set_1i(program, "material.ambient_specular_texture", 0);
-    program_set_1i(program, "material.diffuse_texture", 1);
-    program_set_1f(program, "material.shininess", 64.0f);
-    for(int i = 0; i < dir_sources.size(); i++){
-        std::string enabled = "dir_sources[" + std::to_string(i) + "].enabled";
-        if(i >= 16){break;};
-        if(!dir_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string direction = "dir_sources[" + std::to_string(i) + "].direction";
-        std::string ambient_color = "dir_sources[" + std::to_string(i) + "].ambient_color";
-        std::string diffuse_color = "dir_sources[" + std::to_string(i) + "].diffuse_color";
-        std::string specular_color = "dir_sources[" + std::to_string(i) + "].specular_color";
-        program_set_3f(program, direction, dir_sources[i].direction.x, dir_sources[i].direction.y, dir_sources[i].direction.z);
-        program_set_3f(program, ambient_color, dir_sources[i].ambient.x, dir_sources[i].ambient.y, dir_sources[i].ambient.z);
-        program_set_3f(program, diffuse_color, dir_sources[i].diffuse.x, dir_sources[i].diffuse.y, dir_sources[i].diffuse.z);
-        program_set_3f(program, specular_color, dir_sources[i].specular.x, dir_sources[i].specular.y, dir_sources[i].specular.z);
-    }
-    for(int i = 0; i < point_sources.size(); i++){
-        std::string enabled = "point_sources[" + std::to_string(i) + "].enabled";
-        if(i >= 16){break;};
-        if(!point_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string position = "point_sources[" + std::to_string(i) + "].position";
-        std::string ambient_color = "point_sources[" + std::to_string(i) + "].ambient_color";
-        std::string diffuse_color = "point_sources[" + std::to_string(i) + "].diffuse_color";
-        std::string specular_color = "point_sources[" + std::to_string(i) + "].specular_color";
-        std::string constant = "point_sources[" + std::to_string(i) + "].constant";
-        std::string linear = "point_sources[" + std::to_string(i) + "].linear";
-        std::string quadratic = "point_sources[" + std::to_string(i) + "].quadratic";
-        program_set_3f(program, position, point_sources[i].pos.x, point_sources[i].pos.y, point_sources[i].pos.z);
-        program_set_3f(program, ambient_color, point_sources[i].ambient.x, point_sources[i].ambient.y, point_sources[i].ambient.z);
-        program_set_3f(program, diffuse_color, point_sources[i].diffuse.x, point_sources[i].diffuse.y, point_sources[i].diffuse.z);
-        program_set_3f(program, specular_color, point_sources[i].specular.x, point_sources[i].specular.y, point_sources[i].specular.z);
-        program_set_1f(program, constant, point_sources[i].constant);
-        program_set_1f(program, linear, point_sources[i].linear);
-        program_set_1f(program, quadratic, point_sources[i].quadratic);
-    }
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glUseProgram(0);
-    glBindVertexArray(0);
+void normal_textured_cube::submit(render_queue& queue, const glm::vec3& camera_position){
+    submit_cube(queue, camera_position, &normal_textured_cube::issue_draw);
+}
+
+void normal_textured_cube::issue_draw(void* object){
+    normal_textured_cube& cube = *static_cast<normal_textured_cube*>(object);
+    uniform_table& uniforms = cube.shader->uniforms;
+    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(cube.model)));
+    uniforms.set_M4fv("model", cube.model);
+    uniforms.set_M3fv("normal_transformation", normal_transformation);
+    uniforms.set_2f("texture_layers", cube.texture_layers);
+    uniforms.set_1f("material.shininess", 64.0f);
+    cube.mesh->draw();
 }
 
 /**
@@ -622,82 +374,31 @@ void normal_textured_cube::render(glm::mat4 view, glm::mat4 projection, glm::vec
  */
 class mixed_textured_cube : public textured_cube{
 public:
+    float mix_percentage = 0.3f; // the percentage to mix the textures
     /**
-     * @brief Renders the mixed textured cube.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
-     * @param camera_position The position of the camera.
-     * @param mix_percentage The percentage to mix the textures.
-     * @param dir_sources Vector of directional light sources.
-     * @param point_sources Vector of point light sources.
+     * @brief Queues the mixed textured cube. Camera and lights come from the camera_data and light_data uniform blocks.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, float mix_percentage, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources);
+    void submit(render_queue& queue, const glm::vec3& camera_position);
+private:
+    static void issue_draw(void* object);
 };
 
-void mixed_textured_cube::render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, float mix_percentage, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(model)));
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    program_set_M3fv(program, "normal", normal_transformation);
-    program_set_3f(program, "camera_position", camera_position.x, camera_position.y, camera_position.z);
-    program_set_1i(program, "dir_lights", int(dir_sources.size()));
-    program_set_1i(program, "point_lights", int(point_sources.size()));
-    program_set_1f(program, "mix_percentage", mix_percentage);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    program_set_1i(program, "material.ambient_specular_texture", 0);
-    program_set_1i(program, "material.diffuse_texture", 1);
-    program_set_1f(program, "material.shininess", 64.0f);
-    for(int i = 0; i < dir_sources.size(); i++){
-        std::string enabled = "dir_sources[" + std::to_string(i) + "].enabled";
-        if(i >= 16){break;};
-        if(!dir_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string direction = "dir_sources[" + std::to_string(i) + "].direction";
-        std::string ambient_color = "dir_sources[" + std::to_string(i) + "].ambient_color";
-        std::string diffuse_color = "dir_sources[" + std::to_string(i) + "].diffuse_color";
-        std::string specular_color = "dir_sources[" + std::to_string(i) + "].specular_color";
-        program_set_3f(program, direction, dir_sources[i].direction.x, dir_sources[i].direction.y, dir_sources[i].direction.z);
-        program_set_3f(program, ambient_color, dir_sources[i].ambient.x, dir_sources[i].ambient.y, dir_sources[i].ambient.z);
-        program_set_3f(program, diffuse_color, dir_sources[i].diffuse.x, dir_sources[i].diffuse.y, dir_sources[i].diffuse.z);
-        program_set_3f(program, specular_color, dir_sources[i].specular.x, dir_sources[i].specular.y, dir_sources[i].specular.z);
-    }
-    for(int i = 0; i < point_sources.size(); i++){
-        std::string enabled = "point_sources[" + std::to_string(i) + "].enabled";
-        if(i >= 16){break;};
-        if(!point_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string position = "point_sources[" + std::to_string(i) + "].position";
-        std::string ambient_color = "point_sources[" + std::to_string(i) + "].ambient_color";
-        std::string diffuse_color = "point_sources[" + std::to_string(i) + "].diffuse_color";
-        std::string specular_color = "point_sources[" + std::to_string(i) + "].specular_color";
-        std::string constant = "point_sources[" + std::to_string(i) + "].constant";
-        std::string linear = "point_sources[" + std::to_string(i) + "].linear";
-        std::string quadratic = "point_sources[" + std::to_string(i) + "].quadratic";
-        program_set_3f(program, position, point_sources[i].pos.x, point_sources[i].pos.y, point_sources[i].pos.z);
-        program_set_3f(program, ambient_color, point_sources[i].ambient.x, point_sources[i].ambient.y, point_sources[i].ambient.z);
-        program_set_3f(program, diffuse_color, point_sources[i].diffuse.x, point_sources[i].diffuse.y, point_sources[i].diffuse.z);
-        program_set_3f(program, specular_color, point_sources[i].specular.x, point_sources[i].specular.y, point_sources[i].specular.z);
-        program_set_1f(program, constant, point_sources[i].constant);
-        program_set_1f(program, linear, point_sources[i].linear);
-        program_set_1f(program, quadratic, point_sources[i].quadratic);
-    }
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glUseProgram(0);
-    glBindVertexArray(0);
+void mixed_textured_cube::submit(render_queue& queue, const glm::vec3& camera_position){
+    submit_cube(queue, camera_position, &mixed_textured_cube::issue_draw);
+}
+
+void mixed_textured_cube::issue_draw(void* object){
+    mixed_textured_cube& cube = *static_cast<mixed_textured_cube*>(object);
+    uniform_table& uniforms = cube.shader->uniforms;
+    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(cube.model)));
+    uniforms.set_M4fv("model", cube.model);
+    uniforms.set_M3fv("normal_transformation", normal_transformation);
+    uniforms.set_2f("texture_layers", cube.texture_layers);
+    uniforms.set_1f("mix_percentage", cube.mix_percentage);
+    uniforms.set_1f("material.shininess", 64.0f);
+    cube.mesh->draw();
 }
 
 /**
@@ -706,89 +407,27 @@ void mixed_textured_cube::render(glm::mat4 view, glm::mat4 projection, glm::vec3
 class normal_map_cube : public textured_cube{
 public:
     /**
-     * @brief Sets the VAO for the normal map cube.
-     * @param vertices Pointer to vertex data.
-     * @param size Size of vertex data.
-     */
-    void set_normal_map_VAO(float* vertices, int size);
-    /**
-     * @brief Renders the normal map cube.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
-     * @param camera_position The position of the camera.
-     * @param dir_sources Vector of directional light sources.
-     * @param point_sources Vector of point light sources.
+     * @brief Queues the normal map cube. Camera and lights come from the camera_data and light_data uniform blocks.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources);
+    void submit(render_queue& queue, const glm::vec3& camera_position);
+private:
+    static void issue_draw(void* object);
 };
 
-void normal_map_cube::set_normal_map_VAO(float* vertices, int size){
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(8 * sizeof(float)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void normal_map_cube::submit(render_queue& queue, const glm::vec3& camera_position){
+    submit_cube(queue, camera_position, &normal_map_cube::issue_draw);
 }
 
-void normal_map_cube::render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    program_set_3f(program, "camera_position", camera_position.x, camera_position.y, camera_position.z);
-    program_set_1i(program, "dir_lights", int(dir_sources.size()));
-    program_set_1i(program, "point_lights", int(point_sources.size()));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    program_set_1i(program, "material.diffuse_map", 0);
-    program_set_1i(program, "material.normal_map", 1);
-
-    for(int i = 0; i < dir_sources.size(); i++){
-        std::string enabled = "lightDirEnabled[" + std::to_string(i) + "]";
-        if(i >= 16){break;};
-        if(!dir_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string dir_light = "lightSourceDirection[" + std::to_string(i) + "]";
-        program_set_3f(program, dir_light, dir_sources[i].direction.x, dir_sources[i].direction.y, dir_sources[i].direction.z);
-    }
-    for(int i = 0; i < point_sources.size(); i++){
-        std::string enabled = "lightPointEnabled[" + std::to_string(i) + "]";
-        if(i >= 16){break;};
-        if(!point_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string point_light = "lightSourcePosition[" + std::to_string(i) + "]";
-        program_set_3f(program, point_light, point_sources[i].pos.x, point_sources[i].pos.y, point_sources[i].pos.z);
-    }
-
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glUseProgram(0);
-    glBindVertexArray(0);
+void normal_map_cube::issue_draw(void* object){
+    normal_map_cube& cube = *static_cast<normal_map_cube*>(object);
+    uniform_table& uniforms = cube.shader->uniforms;
+    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(cube.model)));
+    uniforms.set_M4fv("model", cube.model);
+    uniforms.set_M3fv("normal_transformation", normal_transformation);
+    uniforms.set_2f("texture_layers", cube.texture_layers);
+    cube.mesh->draw();
 }
 
 /**
@@ -798,10 +437,13 @@ class quad_object{
 public:
     glm::vec3 pos1, pos2, pos3, pos4, center;
     glm::vec2 uv1, uv2, uv3, uv4;
-    unsigned int texture1, texture2;
+    GLuint texture_array_id = 0;
+    glm::vec2 texture_layers = glm::vec2(0.0f); // the layers of the first and second texture
     GLuint VAO;
     GLuint program;
+    shared_program shader;
     glm::mat4 model;
+    bounding_sphere local_bounds; // around the vertices uploaded by set_VAO or set_simple_VAO
     quad_object(){};
     /**
      * @brief Sets the position of the quad vertices and center.
@@ -813,11 +455,12 @@ public:
      */
     void set_position(glm::vec3 val1, glm::vec3 val2, glm::vec3 val3, glm::vec3 val4, glm::vec3 cent);
     /**
-     * @brief Assigns textures to the quad.
-     * @param tex1 ID of the first texture.
-     * @param tex2 ID of the second texture.
+     * @brief Assigns the texture array and the layers of the quad's textures.
+     * @param array The texture array.
+     * @param layer1 Layer of the first texture.
+     * @param layer2 Layer of the second texture.
      */
-    void assign_textures(unsigned int tex1, unsigned int tex2);
+    void assign_textures(const texture_array& array, int layer1, int layer2);
     /**
      * @brief Sets the UV coordinates for the quad vertices.
      * @param val1 UV coordinate for vertex 1.
@@ -831,20 +474,25 @@ public:
      */
     void set_VAO();
     /**
-     * @brief Sets the shader program for the quad.
-     * @param vertex_path Path to the vertex shader.
-     * @param fragment_path Path to the fragment shader.
+     * @brief Sets the material uber shader permutation of the quad, sharing it with every other user of the same features.
+     * @param features The material_feature flags, MATERIAL_NORMAL_MAP needs the tangents of set_VAO.
      */
-    void set_program(std::string vertex_path, std::string fragment_path);
+    void set_material(unsigned features);
     /**
-     * @brief Renders the quad.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
-     * @param camera_position The position of the camera.
-     * @param dir_sources Vector of directional light sources.
-     * @param point_sources Vector of point light sources.
+     * @brief Queues the quad. Camera and lights come from the camera_data and light_data uniform blocks.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources);
+    void submit(render_queue& queue, const glm::vec3& camera_position);
+    /**
+     * @brief Returns the world space bounding sphere of the quad.
+     */
+    bounding_sphere world_bounds() const;
+protected:
+    /**
+     * @brief Sets the model, normal and layer uniforms and draws the 6 vertices, called once the quad's state is bound.
+     */
+    static void issue_draw(void* object);
 };
 
 void quad_object::set_position(glm::vec3 val1, glm::vec3 val2, glm::vec3 val3, glm::vec3 val4, glm::vec3 cent){
@@ -868,41 +516,8 @@ void quad_object::set_VAO(){
     // calculate tangent/bitangent vectors of both triangles
     glm::vec3 tangent1, bitangent1;
     glm::vec3 tangent2, bitangent2;
-    // triangle 1
-    // ----------
-    glm::vec3 edge1 = pos2 - pos1;
-    glm::vec3 edge2 = pos3 - pos1;
-    glm::vec2 deltaUV1 = uv2 - uv1;
-    glm::vec2 deltaUV2 = uv3 - uv1;
-
-    float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-    tangent1.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-    tangent1.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-    tangent1.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-    bitangent1.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-    bitangent1.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-    bitangent1.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-
-    // triangle 2
-    // ----------
-    edge1 = pos3 - pos1;
-    edge2 = pos4 - pos1;
-    deltaUV1 = uv3 - uv1;
-    deltaUV2 = uv4 - uv1;
-
-    f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-    tangent2.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-    tangent2.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-    tangent2.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-
-    bitangent2.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-    bitangent2.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-    bitangent2.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-
+    triangle_tangents(pos1, pos2, pos3, uv1, uv2, uv3, tangent1, bitangent1);
+    triangle_tangents(pos1, pos3, pos4, uv1, uv3, uv4, tangent2, bitangent2);
 
     float vertices[] = {
         // positions            // normal         // texcoords  // tangent                          // bitangent
@@ -914,6 +529,7 @@ void quad_object::set_VAO(){
         pos3.x, pos3.y, pos3.z, nm.x, nm.y, nm.z, uv3.x, uv3.y, tangent2.x, tangent2.y, tangent2.z, bitangent2.x, bitangent2.y, bitangent2.z,
         pos4.x, pos4.y, pos4.z, nm.x, nm.y, nm.z, uv4.x, uv4.y, tangent2.x, tangent2.y, tangent2.z, bitangent2.x, bitangent2.y, bitangent2.z
     };
+    local_bounds = sphere_from_points(vertices, 6, 14);
     GLuint VBO;
     glGenBuffers(1, &VBO);
     glGenVertexArrays(1, &VAO);
@@ -936,59 +552,40 @@ void quad_object::set_VAO(){
     glBindVertexArray(0);
 }
 
-void quad_object::render(glm::mat4 view, glm::mat4 projection, glm::vec3 camera_position, const std::vector<directional_light_source>& dir_sources, const std::vector<point_light_source>& point_sources){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    program_set_3f(program, "camera_position", camera_position.x, camera_position.y, camera_position.z);
-    program_set_1i(program, "dir_lights", int(dir_sources.size()));
-    program_set_1i(program, "point_lights", int(point_sources.size()));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    program_set_1i(program, "material.diffuse_map", 0);
-    program_set_1i(program, "material.normal_map", 1);
-
-    for(int i = 0; i < dir_sources.size(); i++){
-        std::string enabled = "lightDirEnabled[" + std::to_string(i) + "]";
-        if(i >= 16){break;};
-        if(!dir_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string dir_light = "lightSourceDirection[" + std::to_string(i) + "]";
-        program_set_3f(program, dir_light, dir_sources[i].direction.x, dir_sources[i].direction.y, dir_sources[i].direction.z);
-    }
-    for(int i = 0; i < point_sources.size(); i++){
-        std::string enabled = "lightPointEnabled[" + std::to_string(i) + "]";
-        if(i >= 16){break;};
-        if(!point_sources[i].enabled){
-            program_set_1i(program, enabled, 0);
-            continue;
-        }else{
-            program_set_1i(program, enabled, 1);
-        }
-        std::string point_light = "lightSourcePosition[" + std::to_string(i) + "]";
-        program_set_3f(program, point_light, point_sources[i].pos.x, point_sources[i].pos.y, point_sources[i].pos.z);
-    }
-
+void quad_object::submit(render_queue& queue, const glm::vec3& camera_position){
+    draw_item item;
+    item.program = program;
+    item.VAO = VAO;
+    item.texture1 = texture_array_id;
+    item.texture_target = GL_TEXTURE_2D_ARRAY;
+    item.depth = glm::distance(camera_position, center);
+    item.issue = &quad_object::issue_draw;
+    item.object = this;
+    queue.submit(item);
+}
+
+void quad_object::issue_draw(void* object){
+    quad_object& quad = *static_cast<quad_object*>(object);
+    uniform_table& uniforms = quad.shader->uniforms;
+    glm::mat3 normal_transformation = glm::transpose(glm::inverse(glm::mat3(quad.model)));
+    uniforms.set_M4fv("model", quad.model);
+    uniforms.set_M3fv("normal_transformation", normal_transformation);
+    uniforms.set_2f("texture_layers", quad.texture_layers);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glUseProgram(0);
-    glBindVertexArray(0);
 }
 
-void quad_object::set_program(std::string vertex_path, std::string fragment_path){
-    program = create_shader_program(vertex_path.c_str(), fragment_path.c_str());
+void quad_object::set_material(unsigned features){
+    shader = program_library().acquire(MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(features));
+    program = shader->id;
+}
+
+void quad_object::assign_textures(const texture_array& array, int layer1, int layer2){
+    texture_array_id = array.id();
+    texture_layers = glm::vec2(float(layer1), float(layer2));
 }
 
-void quad_object::assign_textures(unsigned int tex1, unsigned int tex2){
-    texture1 = tex1;
-    texture2 = tex2;
+bounding_sphere quad_object::world_bounds() const{
+    return transform_bounds(local_bounds, model);
 }
 
 /**
@@ -1001,11 +598,11 @@ public:
      */
     void set_simple_VAO();
     /**
-     * @brief Renders the simple quad.
-     * @param view The view matrix.
-     * @param projection The projection matrix.
+     * @brief Queues the simple quad, it only samples the first layer. The camera comes from the camera_data uniform block.
+     * @param queue The render queue of the frame.
+     * @param camera_position The camera position, used for the draw order.
      */
-    void simple_render(glm::mat4 view, glm::mat4 projection);
+    void submit_simple(render_queue& queue, const glm::vec3& camera_position);
 };
 
 void simple_quad::set_simple_VAO(){
@@ -1022,6 +619,7 @@ void simple_quad::set_simple_VAO(){
         pos3.x, pos3.y, pos3.z, nm.x, nm.y, nm.z, uv3.x, uv3.y,
         pos4.x, pos4.y, pos4.z, nm.x, nm.y, nm.z, uv4.x, uv4.y
     };
+    local_bounds = sphere_from_points(vertices, 6, 8);
     GLuint VBO;
     glGenBuffers(1, &VBO);
     glGenVertexArrays(1, &VAO);
@@ -1040,15 +638,16 @@ void simple_quad::set_simple_VAO(){
     glBindVertexArray(0);
 }
 
-void simple_quad::simple_render(glm::mat4 view, glm::mat4 projection){
-    glUseProgram(program);
-    glBindVertexArray(VAO);
-    program_set_M4fv(program, "view", view);
-    program_set_M4fv(program, "projection", projection);
-    program_set_M4fv(program, "model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glUseProgram(0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+void simple_quad::submit_simple(render_queue& queue, const glm::vec3& camera_position){
+    draw_item item;
+    item.program = program;
+    item.VAO = VAO;
+    item.texture1 = texture_array_id;
+    item.texture_target = GL_TEXTURE_2D_ARRAY;
+    item.depth = glm::distance(camera_position, center);
+    item.issue = &quad_object::issue_draw;
+    item.object = this;
+    queue.submit(item);
+}
+
+#endif
@@ -0,0 +1,492 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "microbench.h"
+#include "Camera.h"
+#include "mesh_generator.h"
+#include "mesh_bake.h"
+#include "mesh_file.h"
+#include "mapped_file.h"
+#include "spatial_grid.h"
+#include "uniform_table.h"
+#include "showcase3_functions.h"
+#include "showcase3_scene.h"
+
+// None of the benchmarks below needs a GL context, they only run the CPU side of the engine
+
+const unsigned int MICROBENCH_SEED = 42;
+const char* const POINT_LIGHT_MEMBERS[] = {"position", "ambient", "diffuse", "specular", "constant", "linear", "quadratic", "enabled"};
+
+/**
+ * @brief Scatters unit cubes over the floor and the air above it, like a heavily spawned Showcase3 scene.
+ * @param count The number of cubes.
+ * @param spheres Receives the world bounds of the cubes.
+ */
+void random_cube_bounds(int count, std::vector<bounding_sphere>& spheres){
+    std::mt19937 random(MICROBENCH_SEED);
+    float half_extent = 20.0f * std::sqrt(std::max(1.0f, float(count) / 4096.0f));
+    std::uniform_real_distribution<float> horizontal(-half_extent, half_extent);
+    std::uniform_real_distribution<float> vertical(0.0f, 15.0f);
+    spheres.clear();
+    for(int i = 0; i < count; i++){
+        spheres.push_back(bounding_sphere{glm::vec3(horizontal(random), vertical(random), horizontal(random)), 0.87f});
+    }
+}
+
+/**
+ * @brief Returns 64 picking rays cast from above the middle of the scene, slightly downwards in random directions.
+ */
+void picking_rays(std::vector<glm::vec3>& directions){
+    std::mt19937 random(MICROBENCH_SEED);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    directions.clear();
+    for(int ray = 0; ray < 64; ray++){
+        float yaw = angle(random);
+        directions.push_back(glm::vec3(std::cos(yaw), -0.3f, std::sin(yaw)));
+    }
+}
+
+/**
+ * @brief Fills a spatial grid with spheres, the id of each sphere is its index.
+ */
+void fill_spatial_grid(spatial_grid& grid, const std::vector<bounding_sphere>& spheres){
+    for(size_t i = 0; i < spheres.size(); i++){
+        grid.insert(uint32_t(i), spheres[i]);
+    }
+}
+
+/**
+ * @brief Fills a uniform table with the point light array of the lit shaders, without a program.
+ * @param table The table to fill.
+ * @param names Receives every full uniform name and its location, the baseline of the string lookups.
+ * @param light_count The length of the point light array.
+ */
+void fill_point_light_table(uniform_table& table, std::map<std::string, int>& names, int light_count){
+    GLint location = 0;
+    for(int i = 0; i < light_count; i++){
+        for(const char* member : POINT_LIGHT_MEMBERS){
+            std::string name = "point_sources[" + std::to_string(i) + "]." + member;
+            names[name] = location;
+            table.add_uniform(name, location++, GL_FLOAT);
+        }
+    }
+}
+
+/**
+ * @brief Generates the positions and texture coordinates of quads with random corners.
+ * @param quad_count The number of quads.
+ * @param positions Receives 4 positions per quad.
+ * @param uvs Receives 4 texture coordinates per quad.
+ */
+void random_quads(int quad_count, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& uvs){
+    std::mt19937 random(MICROBENCH_SEED);
+    std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+    positions.clear();
+    uvs.clear();
+    for(int i = 0; i < quad_count; i++){
+        for(int corner = 0; corner < 4; corner++){
+            positions.push_back(glm::vec3(coordinate(random), coordinate(random), coordinate(random)));
+        }
+        uvs.push_back(glm::vec2(0.0f, 1.0f));
+        uvs.push_back(glm::vec2(0.0f, 0.0f));
+        uvs.push_back(glm::vec2(1.0f, 0.0f));
+        uvs.push_back(glm::vec2(1.0f, 1.0f));
+    }
+}
+
+int main(int argc, char** argv){
+    microbench_suite suite;
+
+    // param: sectors of the sphere, with half as many stacks
+    suite.add("generate_tangents/sphere", {8, 32, 128}, [](bench_state& state){
+        mesh_data mesh = generate_sphere(0.5f, state.param, state.param / 2);
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            generate_tangents(mesh);
+            keep(mesh.vertices.data()[MESH_TANGENT_OFFSET]);
+        }
+        state.stop();
+    });
+
+    // param: sectors of the sphere, with half as many stacks
+    suite.add("generate_tangents_parallel/sphere", {8, 32, 128}, [](bench_state& state){
+        mesh_data mesh = generate_sphere(0.5f, state.param, state.param / 2);
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            generate_tangents_parallel(mesh);
+            keep(mesh.vertices.data()[MESH_TANGENT_OFFSET]);
+        }
+        state.stop();
+    });
+
+    // param: sectors of the sphere, with half as many stacks; the triangles are shuffled first, as in an unsorted file
+    suite.add("optimize_vertex_cache/sphere", {32, 128}, [](bench_state& state){
+        mesh_data sphere = generate_sphere(0.5f, state.param, state.param / 2);
+        std::vector<int> order(sphere.indices.size() / 3);
+        for(size_t i = 0; i < order.size(); i++){
+            order[i] = int(i);
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937(MICROBENCH_SEED));
+        std::vector<unsigned int> shuffled;
+        for(int triangle : order){
+            shuffled.insert(shuffled.end(), sphere.indices.begin() + triangle * 3, sphere.indices.begin() + triangle * 3 + 3);
+        }
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            sphere.indices = shuffled;
+            optimize_vertex_cache(sphere);
+            keep(sphere.indices[0]);
+        }
+        state.stop();
+    });
+
+    // param: sectors of the sphere, with half as many stacks; a file written by save_mesh_file is mapped and checked the
+    // way mesh_asset reads it, the run stops if the geometry does not come back unchanged
+    suite.add("mesh_file/map_and_open", {8, 32, 128}, [](bench_state& state){
+        mesh_data sphere = generate_sphere(0.5f, state.param, state.param / 2);
+        const std::string path = "microbench_sphere" + std::string(MESH_FILE_EXTENSION);
+        if(!save_mesh_file(path, {sphere})){
+            std::cout << "Could not write " << path << "!!!" << std::endl;
+            std::exit(1);
+        }
+        bool intact = true;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            mapped_file file;
+            mesh_file_view view;
+            intact = intact && file.open(path) && view.open(file.data(), file.size()) && view.indices_in_range(0)
+                && view.header().vertex_count * size_t(view.header().vertex_stride) == sphere.vertices.size() * sizeof(float)
+                && memcmp(view.vertices(0), sphere.vertices.data(), sphere.vertices.size() * sizeof(float)) == 0;
+        }
+        state.stop();
+        std::remove(path.c_str());
+        if(!intact){
+            std::cout << "The mesh file of a sphere with " << state.param << " sectors does not read back as written!!!" << std::endl;
+            std::exit(1);
+        }
+    });
+
+    suite.add("generate_cube", {1}, [](bench_state& state){
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            mesh_data mesh = generate_cube();
+            keep(mesh.vertices.data()[0]);
+        }
+        state.stop();
+    });
+
+    // param: quads, the two triangles quad_object::set_VAO() computes for each
+    suite.add("triangle_tangents/quads", {1, 64, 4096}, [](bench_state& state){
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        random_quads(state.param, positions, uvs);
+        glm::vec3 tangent, bitangent;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int quad = 0; quad < state.param; quad++){
+                const glm::vec3* p = &positions[quad * 4];
+                const glm::vec2* uv = &uvs[quad * 4];
+                triangle_tangents(p[0], p[1], p[2], uv[0], uv[1], uv[2], tangent, bitangent);
+                keep(tangent);
+                triangle_tangents(p[0], p[2], p[3], uv[0], uv[2], uv[3], tangent, bitangent);
+                keep(bitangent);
+            }
+        }
+        state.stop();
+    });
+
+    // param: mouse events per frame, each one recomputes the camera vectors
+    suite.add("camera/mouse_and_view", {1, 16}, [](bench_state& state){
+        Camera camera(glm::vec3(20.0f, 10.0f, 20.0f));
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int event = 0; event < state.param; event++){
+                camera.ProcessMouseMovement(0.7f, (i + event) % 2 ? 0.3f : -0.3f);
+            }
+            glm::mat4 view = camera.GetViewMatrix();
+            keep(view);
+        }
+        state.stop();
+    });
+
+    // param: spawned cubes moved in one frame
+    suite.add("move_cube/entities", {16, 1024, 65536}, [](bench_state& state){
+        std::mt19937 random(MICROBENCH_SEED);
+        std::uniform_real_distribution<float> horizontal(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> vertical(0.0f, 15.0f);
+        std::vector<glm::vec3> positions;
+        for(int i = 0; i < state.param; i++){
+            positions.push_back(glm::vec3(horizontal(random), vertical(random), horizontal(random)));
+        }
+        const glm::vec3 matrix_center(-30.0f, 0.0f, 0.0f);
+        int arrived = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int entity = 0; entity < state.param; entity++){
+                arrived += move_cube(positions[entity], 1.0f / 600.0f, matrix_center, 2.0f);
+            }
+        }
+        state.stop();
+        keep(arrived);
+        keep(positions[0]);
+    });
+
+    // param: cubes, 64 point light reach queries against all of them, the baseline of the spatial grid
+    suite.add("light_reach/brute_force", {1024, 16384, 131072}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        int found = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int light = 0; light < 64; light++){
+                const bounding_sphere& reach = cubes[(light * 997) % cubes.size()];
+                for(const bounding_sphere& cube : cubes){
+                    glm::vec3 offset = cube.center - reach.center;
+                    float touching = cube.radius + 8.0f;
+                    found += glm::dot(offset, offset) <= touching * touching;
+                }
+            }
+        }
+        state.stop();
+        keep(found);
+    });
+
+    // param: cubes, the same 64 queries as one batch query of the spatial grid
+    suite.add("light_reach/spatial_grid", {1024, 16384, 131072}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        spatial_grid grid;
+        fill_spatial_grid(grid, cubes);
+        std::vector<bounding_sphere> reach;
+        for(int light = 0; light < 64; light++){
+            reach.push_back(bounding_sphere{cubes[(light * 997) % cubes.size()].center, 8.0f});
+        }
+        std::vector<uint32_t> ids;
+        std::vector<int> offsets;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            grid.query_spheres(reach.data(), int(reach.size()), ids, offsets);
+        }
+        state.stop();
+        keep(ids.size());
+    });
+
+    // param: cubes, every one moves a little each iteration as in one simulation step
+    suite.add("spatial_grid/update", {1024, 16384, 131072}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        spatial_grid grid;
+        fill_spatial_grid(grid, cubes);
+        std::vector<uint32_t> ids;
+        for(int i = 0; i < state.param; i++){
+            ids.push_back(uint32_t(i));
+        }
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            float direction = i % 2 == 0 ? 1.0f : -1.0f;
+            for(bounding_sphere& cube : cubes){
+                cube.center.x += 0.13f * direction;
+            }
+            grid.update(ids.data(), cubes.data(), state.param);
+        }
+        state.stop();
+        keep(grid.cell_count());
+    });
+
+    // param: entities spawned into an empty store, then despawned again
+    suite.add("entity_store/spawn_despawn_cold", {1024, 16384}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        const bounding_sphere cube_bounds{glm::vec3(0.0f), 0.87f};
+        int alive = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            entity_store store;
+            std::vector<entity_handle> handles;
+            for(const bounding_sphere& cube : cubes){
+                handles.push_back(store.create(ENTITY_NORMAL_CUBE, cube.center, ENTITY_NORMAL_CUBE, cube_bounds));
+            }
+            for(entity_handle handle : handles){
+                store.destroy(handle);
+            }
+            store.flush_removals();
+            alive += store.size();
+        }
+        state.stop();
+        keep(alive);
+    });
+
+    // param: entities spawned into a store reserved for them at startup, then despawned again
+    suite.add("entity_store/spawn_despawn_reserved", {1024, 16384}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        const bounding_sphere cube_bounds{glm::vec3(0.0f), 0.87f};
+        entity_store store;
+        store.reserve(state.param);
+        std::vector<entity_handle> handles;
+        handles.reserve(cubes.size());
+        int alive = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            handles.clear();
+            for(const bounding_sphere& cube : cubes){
+                handles.push_back(store.create(ENTITY_NORMAL_CUBE, cube.center, ENTITY_NORMAL_CUBE, cube_bounds));
+            }
+            for(entity_handle handle : handles){
+                store.destroy(handle);
+            }
+            store.flush_removals();
+            alive += store.size();
+        }
+        state.stop();
+        keep(alive);
+    });
+
+    // param: live entities, 64 of them despawned and 64 spawned elsewhere per iteration, like cubes reaching the floor
+    suite.add("entity_store/churn", {1024, 16384}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param * 2, cubes);
+        const bounding_sphere cube_bounds{glm::vec3(0.0f), 0.87f};
+        entity_store store;
+        store.reserve(state.param);
+        for(int i = 0; i < state.param; i++){
+            store.create(ENTITY_NORMAL_CUBE, cubes[i].center, ENTITY_NORMAL_CUBE, cube_bounds);
+        }
+        std::mt19937 random(MICROBENCH_SEED);
+        int next_cube = state.param;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int removed = 0; removed < 64; removed++){
+                store.destroy(store.handle_at(int(random() % uint32_t(state.param))));
+            }
+            store.flush_removals();
+            while(store.size() < state.param){
+                store.create(ENTITY_NORMAL_CUBE, cubes[next_cube].center, ENTITY_NORMAL_CUBE, cube_bounds);
+                next_cube = (next_cube + 1) % int(cubes.size());
+            }
+        }
+        state.stop();
+        keep(store.index().cell_count());
+    });
+
+    // param: cubes, 64 picking rays tested against every cube's bounds, as picking did without the grid
+    suite.add("raycast/brute_force", {1024, 16384, 131072}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        std::vector<glm::vec3> directions;
+        picking_rays(directions);
+        const glm::vec3 origin(0.0f, 20.0f, 0.0f);
+        int hits = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(const glm::vec3& direction : directions){
+                glm::vec3 dir = glm::normalize(direction);
+                float best = 100.0f;
+                int closest = -1;
+                for(int cube = 0; cube < state.param; cube++){
+                    glm::vec3 offset = origin - cubes[cube].center;
+                    float b = glm::dot(offset, dir);
+                    float discriminant = b * b - glm::dot(offset, offset) + cubes[cube].radius * cubes[cube].radius;
+                    if(discriminant < 0.0f){
+                        continue;
+                    }
+                    float hit = -b - std::sqrt(discriminant);
+                    if(hit >= 0.0f && hit < best){
+                        best = hit;
+                        closest = cube;
+                    }
+                }
+                hits += closest >= 0;
+            }
+        }
+        state.stop();
+        keep(hits);
+    });
+
+    // param: cubes, the same 64 picking rays walked through the spatial grid
+    suite.add("raycast/spatial_grid", {1024, 16384, 131072}, [](bench_state& state){
+        std::vector<bounding_sphere> cubes;
+        random_cube_bounds(state.param, cubes);
+        spatial_grid grid;
+        fill_spatial_grid(grid, cubes);
+        std::vector<glm::vec3> directions;
+        picking_rays(directions);
+        int hits = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(const glm::vec3& direction : directions){
+                uint32_t id;
+                float distance;
+                hits += grid.raycast(glm::vec3(0.0f, 20.0f, 0.0f), direction, 100.0f, id, distance);
+            }
+        }
+        state.stop();
+        keep(hits);
+    });
+
+    // param: point lights, every member of every light is looked up once per iteration
+    suite.add("uniform_names/string_building", {4, 64}, [](bench_state& state){
+        uniform_table table;
+        std::map<std::string, int> names;
+        fill_point_light_table(table, names, state.param);
+        int sum = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int light = 0; light < state.param; light++){
+                for(const char* member : POINT_LIGHT_MEMBERS){
+                    sum += names.find("point_sources[" + std::to_string(light) + "]." + member)->second;
+                }
+            }
+        }
+        state.stop();
+        keep(sum);
+    });
+
+    suite.add("uniform_names/slot_by_name", {4, 64}, [](bench_state& state){
+        uniform_table table;
+        std::map<std::string, int> names;
+        fill_point_light_table(table, names, state.param);
+        int sum = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(int light = 0; light < state.param; light++){
+                for(const char* member : POINT_LIGHT_MEMBERS){
+                    sum += table.slot("point_sources", light, member);
+                }
+            }
+        }
+        state.stop();
+        keep(sum);
+    });
+
+    suite.add("uniform_names/array_slots", {4, 64}, [](bench_state& state){
+        uniform_table table;
+        std::map<std::string, int> names;
+        fill_point_light_table(table, names, state.param);
+        int sum = 0;
+        state.start();
+        for(int i = 0; i < state.iterations; i++){
+            for(const char* member : POINT_LIGHT_MEMBERS){
+                const std::vector<int>& column = table.array_slots("point_sources", member);
+                for(int slot : column){
+                    sum += slot;
+                }
+            }
+        }
+        state.stop();
+        keep(sum);
+    });
+
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,359 @@
+#ifndef SHOWCASE3_SCENE_H
+#define SHOWCASE3_SCENE_H
+
+#include <vector>
+#include "showcase3_functions.h"
+#include "instance_batch.h"
+#include "entity_store.h"
+#include "job_system.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "texture_array.h"
+
+// Size every material image is resampled to in the texture array
+const int MATERIAL_TEXTURE_SIZE = 512;
+// Entities moved or interpolated by a single job
+const int UPDATE_GRAIN = 256;
+// Entities the scene is sized for at startup, spawning and removing below it allocates nothing
+const int SPAWN_POOL_SIZE = 4096;
+// Material images streamed at the same time, each needs a pixel buffer while it uploads
+const int TEXTURE_UPLOAD_BUFFERS = 2;
+
+// Baked by meshbake next to the executable at build time
+const char* const SCENE_CUBE_MESH = "./res/Meshes/cube.mesh";
+
+// The light markers are drawn white or black, without the material shader
+const char* const LIGHT_MARKER_VERTEX_SHADER = "./res/Shaders/VertexShader1_31.txt";
+const char* const LIGHT_MARKER_FRAGMENT_SHADER = "./res/Shaders/FragmentShader1_31.txt";
+
+// Material permutations of the lit objects, the matrix floor is MATERIAL_UNLIT
+const unsigned NORMAL_CUBE_MATERIAL = MATERIAL_DIFFUSE_MAP;
+const unsigned MIXED_CUBE_MATERIAL = MATERIAL_MIX_MAP;
+const unsigned NORMAL_MAP_CUBE_MATERIAL = MATERIAL_NORMAL_MAP;
+const unsigned FLOOR_MATERIAL = MATERIAL_NORMAL_MAP;
+const unsigned SCENE_MATERIALS[] = {NORMAL_CUBE_MATERIAL, MIXED_CUBE_MATERIAL, NORMAL_MAP_CUBE_MATERIAL};
+
+/**
+ * @brief The texture array of every Showcase3 material and the layer of each image in it.
+ */
+struct scene_textures{
+    texture_array array;
+    int container = 0;
+    int container2 = 0;
+    int container2_specular = 0;
+    int matrix = 0;
+    int brickwall = 0;
+    int brickwall_normal = 0;
+    int awesome_face = 0;
+};
+
+/**
+ * @brief Returns the cube every Showcase3 object is drawn with: the one baked at build time, uploaded from the mapped
+ * file, or the generated cube if the file is missing or invalid.
+ */
+const gpu_mesh& scene_cube(){
+    static const gpu_mesh* cube = nullptr;
+    if(cube == nullptr){
+        mesh_asset* baked = mesh_library().load(SCENE_CUBE_MESH);
+        cube = baked != nullptr ? baked->submesh(0) : nullptr;
+        if(cube == nullptr){
+            cube = &mesh_library().cube();
+        }
+    }
+    return *cube;
+}
+
+/**
+ * @brief Requests the material textures from ./res/Images into one texture array, the layers show a placeholder until
+ * texture_library() has streamed them in.
+ * @return The texture array and the layers.
+ */
+scene_textures load_scene_textures(){
+    scene_textures textures;
+    textures.array.create(MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_SIZE, 7);
+    textures.container = textures.array.add("./res/Images/container.jpg");
+    textures.container2 = textures.array.add("./res/Images/container2.png");
+    textures.container2_specular = textures.array.add("./res/Images/container2_specular.png");
+    textures.matrix = textures.array.add("./res/Images/matrix.jpg");
+    textures.brickwall = textures.array.add("./res/Images/brickwall.jpg");
+    textures.brickwall_normal = textures.array.add("./res/Images/brickwall_normal.jpg");
+    textures.awesome_face = textures.array.add("./res/Images/awesomeface.png");
+    return textures;
+}
+
+/**
+ * @brief Registers the texture unit the material sampler reads, so every program gets it set once at link.
+ */
+void register_material_samplers(){
+    program_library().set_sampler_binding("material_textures", 0);
+}
+
+/**
+ * @brief Queues every program of the scene and builds them in one batch, the objects and batches then acquire them
+ * without compiling.
+ */
+void preload_scene_programs(){
+    // The demo objects use the plain variants, the entity batches the instanced ones
+    program_library().preload(LIGHT_MARKER_VERTEX_SHADER, LIGHT_MARKER_FRAGMENT_SHADER);
+    program_library().preload(LIGHT_MARKER_VERTEX_SHADER, LIGHT_MARKER_FRAGMENT_SHADER, instanced_defines(""));
+    for(unsigned features : SCENE_MATERIALS){
+        program_library().preload(MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(features));
+        program_library().preload(MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, instanced_defines(material_defines(features)));
+    }
+    program_library().preload(MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(MATERIAL_UNLIT));
+    program_library().compile_pending();
+}
+
+/**
+ * @brief Creates the instance batch of every entity type with its program, textures and material constants.
+ * @param batches The batches, indexed by entity_type.
+ * @param textures The material texture array and layers.
+ */
+void create_entity_batches(instance_batch (&batches)[ENTITY_TYPE_COUNT], const scene_textures& textures){
+    batches[ENTITY_POINT_LIGHT].create(scene_cube(), LIGHT_MARKER_VERTEX_SHADER, LIGHT_MARKER_FRAGMENT_SHADER);
+    instance_batch& normal_cube_batch = batches[ENTITY_NORMAL_CUBE];
+    normal_cube_batch.create(scene_cube(), MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(NORMAL_CUBE_MATERIAL));
+    normal_cube_batch.assign_textures(textures.array, textures.container2, textures.container2_specular);
+    normal_cube_batch.set_material_1f("material.shininess", 64.0f);
+    instance_batch& mixed_cube_batch = batches[ENTITY_MIXED_CUBE];
+    mixed_cube_batch.create(scene_cube(), MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(MIXED_CUBE_MATERIAL));
+    mixed_cube_batch.assign_textures(textures.array, textures.container, textures.awesome_face);
+    mixed_cube_batch.set_material_1f("material.shininess", 64.0f);
+    mixed_cube_batch.set_material_1f("mix_percentage", 0.3f);
+    instance_batch& normal_map_cube_batch = batches[ENTITY_NORMAL_MAP_CUBE];
+    normal_map_cube_batch.create(scene_cube(), MATERIAL_VERTEX_SHADER, MATERIAL_FRAGMENT_SHADER, material_defines(NORMAL_MAP_CUBE_MATERIAL));
+    normal_map_cube_batch.assign_textures(textures.array, textures.brickwall, textures.brickwall_normal);
+}
+
+/**
+ * @brief Sizes the entity components and the instance batches for a number of entities, so that spawn and despawn
+ * churn below it reuses their memory instead of growing it.
+ * @param scene The entity store.
+ * @param batches The batches, indexed by entity_type.
+ * @param capacity The most entities expected alive at once.
+ */
+void prewarm_entity_pools(entity_store& scene, instance_batch (&batches)[ENTITY_TYPE_COUNT], int capacity){
+    scene.reserve(capacity);
+    // Any type may make up the whole scene
+    for(instance_batch& batch : batches){
+        batch.reserve(capacity);
+    }
+}
+
+/**
+ * @brief Returns the parameters of a spawned point light.
+ */
+light_params spawned_point_light(){
+    light_params point_light;
+    point_light.ambient = glm::vec3(0.25f);
+    point_light.diffuse = glm::vec3(0.25f);
+    point_light.specular = glm::vec3(0.25f);
+    point_light.constant = 1.0f;
+    point_light.linear = 0.045f;
+    point_light.quadratic = 0.0075f;
+    point_light.enabled = true;
+    return point_light;
+}
+
+/**
+ * @brief Moves a cube by one simulation step based on its position relative to the matrix floor: it falls to the floor,
+ * then slides towards the matrix.
+ * @param position The position vector of the cube.
+ * @param step_time The duration of the step.
+ * @param matrix_position The position of the matrix floor center.
+ * @param speed The falling and sliding speed.
+ * @return True if the cube reached the matrix floor and has to be removed.
+ */
+bool move_cube(glm::vec3& position, float step_time, glm::vec3 matrix_position, float speed){
+    if(position.y > 0.01){
+        position = glm::vec3(position.x, position.y - step_time * speed, position.z);
+    }else{
+        float x_dir, z_dir;
+        if(matrix_position.x > position.x){
+            x_dir = 1.0f;
+        }else{
+            x_dir = -1.0f;
+        }
+        if(matrix_position.z > position.z){
+            z_dir = 1.0f;
+        }else{
+            z_dir = -1.0f;
+        }
+        position = glm::vec3(position.x + speed * step_time * x_dir, position.y, position.z + speed * step_time * z_dir);
+        if(abs(position.x - matrix_position.x) < 0.5f && abs(position.z - matrix_position.z) < 0.5f){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Simulation state of the matrix floor, which slides around the edge of the main floor.
+ * Like the entities it keeps the center of the previous step for the renderer to interpolate from.
+ */
+struct matrix_floor_path{
+    glm::vec3 center = glm::vec3(0.0f, 0.01f, 0.0f);
+    glm::vec3 previous_center = glm::vec3(0.0f, 0.01f, 0.0f);
+    glm::vec3 direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    /**
+     * @brief Moves the floor by one simulation step, turning at the corners of its square path.
+     * @param step_time The duration of the step.
+     * @param speed The sliding speed.
+     */
+    void step(float step_time, float speed);
+    /**
+     * @brief Returns the center to draw the floor at.
+     * @param alpha The interpolation factor between the previous and the current step.
+     */
+    glm::vec3 interpolated(float alpha) const;
+};
+
+void matrix_floor_path::step(float step_time, float speed){
+    previous_center = center;
+    center += direction * (step_time * speed);
+    if(center.x >= 17.5 && direction.x == 1.0f){
+        direction = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    if(center.z >= 17.5 && direction.z == 1.0f){
+        direction = glm::vec3(-1.0f, 0.0f, 0.0f);
+    }
+    if(center.x <= -17.5 && direction.x == -1.0f){
+        direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    }
+    if(center.z <= -17.5 && direction.z == -1.0f){
+        direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    }
+}
+
+glm::vec3 matrix_floor_path::interpolated(float alpha) const{
+    return glm::mix(previous_center, center, alpha);
+}
+
+/**
+ * @brief Runs one simulation step of the spawned entities on every core, then removes the ones that reached the matrix floor.
+ * @param scene The spawned entities.
+ * @param reached_floor Per entity flag written by the parallel pass, resized to the scene.
+ * @param step_time The duration of the step.
+ * @param matrix_center The center of the matrix floor at this step.
+ * @param speed The falling and sliding speed.
+ * @param point_lights_on Whether the spawned point lights shine during this step.
+ */
+void step_entities(entity_store& scene, std::vector<unsigned char>& reached_floor, float step_time, glm::vec3 matrix_center,
+    float speed, bool point_lights_on){
+    scene.begin_step();
+    reached_floor.assign(scene.size(), 0);
+    //Each range only writes the entities it was given
+    job_pool().parallel_for(scene.size(), UPDATE_GRAIN, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            if(scene.types[i] == ENTITY_POINT_LIGHT){
+                scene.lights[i].enabled = point_lights_on;
+            }
+            reached_floor[i] = move_cube(scene.positions[i], step_time, matrix_center, speed);
+        }
+    });
+    for(int i = 0; i < scene.size(); i++){
+        if(reached_floor[i]){
+            scene.destroy(scene.handle_at(i));
+        }
+    }
+    scene.flush_removals();
+}
+
+/**
+ * @brief Places every spawned entity between its last two simulation states and updates its world bounds, on every core,
+ * then moves the entities that changed cell in the scene's spatial grid.
+ * @param scene The spawned entities.
+ * @param alpha The interpolation factor between the previous and the current step.
+ */
+void interpolate_entities(entity_store& scene, float alpha){
+    job_pool().parallel_for(scene.size(), UPDATE_GRAIN, [&](int begin, int end){
+        for(int i = begin; i < end; i++){
+            glm::vec3 position = glm::mix(scene.previous_positions[i], scene.positions[i], alpha);
+            scene.models[i] = glm::translate(glm::mat4(1.0f), position);
+            scene.bounds[i] = transform_bounds(scene.local_bounds[i], scene.models[i]);
+        }
+    });
+    scene.update_index();
+}
+
+/**
+ * @brief Returns the world space ray through a point of the screen, from the near plane away from the camera.
+ * @param view The view matrix.
+ * @param projection The projection matrix.
+ * @param cursor The point, in pixels from the top left corner.
+ * @param viewport The size of the screen in pixels.
+ * @param origin Receives the start of the ray.
+ * @param direction Receives the normalized direction of the ray.
+ */
+void screen_ray(const glm::mat4& view, const glm::mat4& projection, glm::vec2 cursor, glm::vec2 viewport, glm::vec3& origin, glm::vec3& direction){
+    glm::mat4 clip_to_world = glm::inverse(projection * view);
+    glm::vec2 ndc(2.0f * cursor.x / viewport.x - 1.0f, 1.0f - 2.0f * cursor.y / viewport.y);
+    glm::vec4 near_point = clip_to_world * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 far_point = clip_to_world * glm::vec4(ndc, 1.0f, 1.0f);
+    origin = glm::vec3(near_point) / near_point.w;
+    direction = glm::normalize(glm::vec3(far_point) / far_point.w - origin);
+}
+
+/**
+ * @brief Returns the spawned entity whose bounds a ray hits first, found through the scene's spatial grid.
+ * @param scene The spawned entities.
+ * @param origin The start of the ray.
+ * @param direction The direction of the ray.
+ * @param max_distance The length of the ray.
+ * @return The dense index of the entity, or -1 if the ray hits none.
+ */
+int pick_entity(const entity_store& scene, const glm::vec3& origin, const glm::vec3& direction, float max_distance){
+    uint32_t slot;
+    float distance;
+    return scene.index().raycast(origin, direction, max_distance, slot, distance) ? scene.slot_to_dense(slot) : -1;
+}
+
+/**
+ * @brief Counts the spawned cubes inside the reach of every point light, with one batch query of the scene's spatial grid.
+ * @param scene The spawned entities.
+ * @param reach One sphere per point light, its center and range.
+ * @param ids Scratch for the query results.
+ * @param offsets Scratch for the query offsets.
+ * @return The number of light and cube pairs, a cube reached by two lights counts twice.
+ */
+int count_lit_cubes(const entity_store& scene, const std::vector<bounding_sphere>& reach, std::vector<uint32_t>& ids, std::vector<int>& offsets){
+    scene.index().query_spheres(reach.data(), int(reach.size()), ids, offsets);
+    int pairs = 0;
+    for(uint32_t slot : ids){
+        pairs += scene.types[scene.slot_to_dense(slot)] != ENTITY_POINT_LIGHT;
+    }
+    return pairs;
+}
+
+/**
+ * @brief Culls the spawned entities and submits the visible ones, one instanced draw per material.
+ * @param scene The spawned entities, their world bounds must be up to date.
+ * @param view_frustum The frustum of this frame.
+ * @param visible Per entity culling result, resized to the scene.
+ * @param batches The batches, indexed by entity_type.
+ * @param queue The render queue of the frame.
+ * @param type_passes The profiler pass of every entity type, indexed by entity_type. Null leaves the batches in the running pass.
+ * @return The number of visible entities.
+ */
+int submit_entities(const entity_store& scene, const frustum& view_frustum, std::vector<unsigned char>& visible,
+    instance_batch (&batches)[ENTITY_TYPE_COUNT], render_queue& queue, const int* type_passes = nullptr){
+    visible.resize(scene.size());
+    int visible_count = cull_spheres(view_frustum, scene.bounds.data(), scene.size(), visible.data());
+    for(instance_batch& batch : batches){
+        batch.begin();
+    }
+    for(int i = 0; i < scene.size(); i++){
+        if(visible[i]){
+            batches[scene.materials[i]].add(scene.models[i], scene.lights[i].enabled);
+        }
+    }
+    for(int type = 0; type < ENTITY_TYPE_COUNT; type++){
+        if(type_passes != nullptr){
+            profiler().begin(type_passes[type]);
+        }
+        batches[type].submit(queue);
+    }
+    return visible_count;
+}
+
+#endif